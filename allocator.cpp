@@ -0,0 +1,251 @@
+// CMSC 341 - Fall 2024 - Project 4
+#include "allocator.h"
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+const int HUGEMPOLPREFERRED = 1;  // MPOL_PREFERRED of mbind(2), numaif.h isn't needed for one constant
+const int HUGEMAXNODES = 1024;    // nodes the mbind mask covers
+const size_t SMALLPAGE = 4096;
+
+BudgetArena::BudgetArena(size_t budget):
+m_slabs(nullptr),
+m_slabCursor(nullptr),
+m_slabLeft(0),
+m_budget(budget),
+m_inUse(0),
+m_reserved(0),
+m_largeOut(0),
+m_large(nullptr)
+{
+    for (size_t i = 0; i < NUMCLASSES; i++) {
+        m_freeLists[i] = nullptr;
+    }
+}
+
+BudgetArena::~BudgetArena(){
+    // the small blocks live in the slabs, the large ones were returned by their owners
+    while (m_slabs != nullptr) {
+        Slab* next = m_slabs->next;
+        free(m_slabs);
+        m_slabs = next;
+    }
+}
+
+void* BudgetArena::allocate(size_t bytes){
+    if (bytes == 0) {
+        bytes = 1;
+    }
+    lock_guard<mutex> lock(m_mutex);
+    if (bytes > SMALLMAX) {
+        void* block = m_large != nullptr ? m_large->allocate(bytes) : malloc(bytes);
+        if (block == nullptr) {
+            throw bad_alloc();
+        }
+        m_inUse += bytes;
+        m_reserved += bytes;
+        m_largeOut++;
+        return block;
+    }
+
+    size_t sizeClass = (bytes + SIZECLASS - 1) / SIZECLASS - 1;
+    size_t classBytes = (sizeClass + 1) * SIZECLASS;
+    m_inUse += classBytes;
+    if (m_freeLists[sizeClass] != nullptr) {
+        FreeBlock* block = m_freeLists[sizeClass];
+        m_freeLists[sizeClass] = block->next;
+        return block;
+    }
+    if (m_slabLeft < classBytes) {
+        // the rest of the current slab is too small, start a new one
+        Slab* slab = (Slab*)malloc(SLABSIZE);
+        if (slab == nullptr) {
+            throw bad_alloc();
+        }
+        slab->next = m_slabs;
+        m_slabs = slab;
+        m_slabCursor = (char*)slab + SIZECLASS; // keeps the blocks 16 byte aligned
+        m_slabLeft = SLABSIZE - SIZECLASS;
+        m_reserved += SLABSIZE;
+    }
+    void* block = m_slabCursor;
+    m_slabCursor += classBytes;
+    m_slabLeft -= classBytes;
+    return block;
+}
+
+void BudgetArena::deallocate(void* ptr, size_t bytes){
+    if (ptr == nullptr) {
+        return;
+    }
+    if (bytes == 0) {
+        bytes = 1;
+    }
+    lock_guard<mutex> lock(m_mutex);
+    if (bytes > SMALLMAX) {
+        if (m_large != nullptr) {
+            m_large->deallocate(ptr, bytes);
+        }else {
+            free(ptr);
+        }
+        m_inUse -= bytes;
+        m_reserved -= bytes;
+        m_largeOut--;
+        return;
+    }
+    size_t sizeClass = (bytes + SIZECLASS - 1) / SIZECLASS - 1;
+    FreeBlock* block = (FreeBlock*)ptr;
+    block->next = m_freeLists[sizeClass];
+    m_freeLists[sizeClass] = block;
+    m_inUse -= (sizeClass + 1) * SIZECLASS;
+}
+
+bool BudgetArena::canAllocate(size_t bytes) const{
+    lock_guard<mutex> lock(m_mutex);
+    return m_inUse + bytes <= m_budget;
+}
+
+bool BudgetArena::setLargeAllocator(TableAllocator* large){
+    lock_guard<mutex> lock(m_mutex);
+    // a block has to go back to the allocator it came from
+    if (m_largeOut > 0) {
+        return false;
+    }
+    m_large = large;
+    return true;
+}
+
+size_t BudgetArena::budget() const{
+    lock_guard<mutex> lock(m_mutex);
+    return m_budget;
+}
+
+void BudgetArena::setBudget(size_t budget){
+    lock_guard<mutex> lock(m_mutex);
+    m_budget = budget;
+}
+
+size_t BudgetArena::bytesInUse() const{
+    lock_guard<mutex> lock(m_mutex);
+    return m_inUse;
+}
+
+size_t BudgetArena::bytesReserved() const{
+    lock_guard<mutex> lock(m_mutex);
+    return m_reserved;
+}
+
+HugePageAllocator::HugePageAllocator(bool explicitPages, int node):
+m_explicitPages(explicitPages),
+m_node(node),
+m_mapped(0),
+m_fallbacks(0)
+{
+}
+
+void* HugePageAllocator::allocate(size_t bytes){
+    if (bytes < HUGEPAGE) {
+        void* block = malloc(bytes == 0 ? 1 : bytes);
+        if (block == nullptr) {
+            throw bad_alloc();
+        }
+        return block;
+    }
+    size_t size = mappedSize(bytes, m_explicitPages);
+    void* block = nullptr;
+    if (m_explicitPages) {
+        // a huge page mapping starts on a huge page boundary by itself
+        block = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (block == MAP_FAILED) {
+            block = nullptr;
+            lock_guard<mutex> lock(m_mutex);
+            m_fallbacks++;
+        }
+    }
+    if (block == nullptr) {
+        block = mapAligned(size);
+    }
+    bindToNode(block, size);
+    lock_guard<mutex> lock(m_mutex);
+    m_mapped += size;
+    return block;
+}
+
+void HugePageAllocator::deallocate(void* ptr, size_t bytes){
+    if (ptr == nullptr) {
+        return;
+    }
+    if (bytes < HUGEPAGE) {
+        free(ptr);
+        return;
+    }
+    size_t size = mappedSize(bytes, m_explicitPages);
+    munmap(ptr, size);
+    lock_guard<mutex> lock(m_mutex);
+    m_mapped -= size;
+}
+
+size_t HugePageAllocator::bytesMapped() const{
+    lock_guard<mutex> lock(m_mutex);
+    return m_mapped;
+}
+
+int HugePageAllocator::fallbacks() const{
+    lock_guard<mutex> lock(m_mutex);
+    return m_fallbacks;
+}
+
+int HugePageAllocator::currentNode(){
+    unsigned int cpu = 0;
+    unsigned int node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+        return 0;
+    }
+    return node;
+}
+
+// A huge page pool mapping is a whole number of huge pages; a transparent one only
+// needs whole small pages, the tail past the last huge page gets small ones.
+// The size depends on the mode alone, so deallocate finds it from the block size.
+size_t HugePageAllocator::mappedSize(size_t bytes, bool explicitPages){
+    size_t page = explicitPages ? HUGEPAGE : SMALLPAGE;
+    return (bytes + page - 1) / page * page;
+}
+
+/*
+mmap only promises a small page boundary, so one huge page more is mapped and
+the ends outside the first huge page boundary are unmapped again. madvise asks
+for transparent huge pages, the kernel uses small ones where it has none.
+*/
+void* HugePageAllocator::mapAligned(size_t bytes){
+    void* area = mmap(nullptr, bytes + HUGEPAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (area == MAP_FAILED) {
+        throw bad_alloc();
+    }
+    uintptr_t start = (uintptr_t)area;
+    uintptr_t aligned = (start + HUGEPAGE - 1) / HUGEPAGE * HUGEPAGE;
+    if (aligned > start) {
+        munmap(area, aligned - start);
+    }
+    size_t tail = start + bytes + HUGEPAGE - (aligned + bytes);
+    if (tail > 0) {
+        munmap((void*)(aligned + bytes), tail);
+    }
+    madvise((void*)aligned, bytes, MADV_HUGEPAGE);
+    return (void*)aligned;
+}
+
+// Nothing has touched the pages yet, so they are all placed by the policy.
+// A kernel without NUMA support refuses mbind, the pages go wherever it puts them.
+void HugePageAllocator::bindToNode(void* ptr, size_t bytes) const{
+    int node = m_node == HUGENODELOCAL ? currentNode() : m_node;
+    if (node < 0 or node >= HUGEMAXNODES) {
+        return;
+    }
+    unsigned long mask[HUGEMAXNODES / (8 * sizeof(unsigned long))] = {0};
+    mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+    syscall(SYS_mbind, ptr, bytes, HUGEMPOLPREFERRED, mask, (unsigned long)HUGEMAXNODES, 0);
+}
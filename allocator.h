@@ -0,0 +1,101 @@
+// CMSC 341 - Fall 2024 - Project 4
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+#include <cstddef>
+#include <mutex>
+using namespace std;
+
+const size_t HUGEPAGE = 2 * 1024 * 1024; // size of a huge page on x86-64
+const int HUGENODELOCAL = -1; // a HugePageAllocator node: the node of the thread that allocates
+
+// Source of the memory of the FileSys tables and entries. A FileSys object
+// given an allocator takes all of its table arrays and entries from it
+// instead of new and delete, and asks canAllocate() before it grows.
+class TableAllocator{
+    public:
+    virtual ~TableAllocator(){}
+    virtual void* allocate(size_t bytes) = 0;
+    // bytes must be the size the memory was allocated with
+    virtual void deallocate(void* ptr, size_t bytes) = 0;
+    // returns true if bytes more can be allocated within the allocator's limits
+    virtual bool canAllocate(size_t) const {return true;}
+};
+
+// Arena shared by many FileSys objects under one memory budget.
+//
+// Small blocks (the names too long to be stored inline in a slot) are carved
+// out of 64 KiB slabs and recycled through free lists per 16 byte size class,
+// which avoids the per-object malloc overhead; larger blocks (the table
+// arrays) come from malloc. The
+// budget is a limit on the bytes handed out: the FileSys objects check it
+// with canAllocate() before inserting and growing, allocate() itself never
+// fails because of it. The arena is safe to use from several threads.
+class BudgetArena : public TableAllocator{
+    public:
+    BudgetArena(size_t budget);
+    ~BudgetArena();
+    void* allocate(size_t bytes);
+    void deallocate(void* ptr, size_t bytes);
+    bool canAllocate(size_t bytes) const;
+    // takes the large blocks from another allocator instead of malloc; only
+    // allowed while no large block is out, returns false otherwise
+    bool setLargeAllocator(TableAllocator* large);
+    size_t budget() const;
+    void setBudget(size_t budget);
+    size_t bytesInUse() const;     // bytes handed out and not returned yet
+    size_t bytesReserved() const;  // bytes taken from the system: slabs and large blocks
+    private:
+    static const size_t SIZECLASS = 16;        // granularity of the small size classes
+    static const size_t SMALLMAX = 128;        // largest block served from the slabs
+    static const size_t NUMCLASSES = SMALLMAX / SIZECLASS;
+    static const size_t SLABSIZE = 64 * 1024;
+
+    struct FreeBlock { FreeBlock* next; };     // a returned small block, linked in its free list
+    struct Slab { Slab* next; };               // header of every slab, linked for the destructor
+
+    FreeBlock* m_freeLists[NUMCLASSES];
+    Slab*      m_slabs;
+    char*      m_slabCursor;                   // free space at the end of the newest slab
+    size_t     m_slabLeft;
+    size_t     m_budget;
+    size_t     m_inUse;
+    size_t     m_reserved;
+    size_t     m_largeOut;                     // large blocks not returned yet
+    TableAllocator* m_large;                   // source of the large blocks, nullptr for malloc
+    mutable std::mutex m_mutex;
+};
+
+// Allocator that backs the table arrays with huge pages.
+//
+// A block of at least HUGEPAGE bytes is mapped on its own, starting on a huge
+// page boundary. By default the kernel is asked to back it with transparent
+// huge pages (madvise); with explicitPages it is taken from the reserved huge
+// page pool (MAP_HUGETLB) first, and from transparent ones when the pool is
+// empty. A probe then costs one TLB entry per 2 MiB instead of per 4 KiB.
+// The mapping is also bound to a NUMA node before it is first touched: the
+// node given, or with HUGENODELOCAL the node of the thread that allocates, so a
+// table ends up next to the thread that grows it. The binding is a preference,
+// a full node still hands out memory from another one. Smaller blocks (small
+// tables and long names) come from malloc. Safe to use from several threads.
+class HugePageAllocator : public TableAllocator{
+    public:
+    HugePageAllocator(bool explicitPages = false, int node = HUGENODELOCAL);
+    void* allocate(size_t bytes);
+    void deallocate(void* ptr, size_t bytes);
+    size_t bytesMapped() const;     // bytes of the huge page mappings out
+    int fallbacks() const;          // explicit huge page mappings the pool had no room for
+    // returns the NUMA node of the CPU the calling thread runs on, 0 if unknown
+    static int currentNode();
+    private:
+    bool   m_explicitPages;
+    int    m_node;
+    size_t m_mapped;
+    int    m_fallbacks;
+    mutable std::mutex m_mutex;
+
+    static size_t mappedSize(size_t bytes, bool explicitPages);
+    void* mapAligned(size_t bytes);
+    void bindToNode(void* ptr, size_t bytes) const;
+};
+
+#endif
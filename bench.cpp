@@ -0,0 +1,506 @@
+// CMSC 341 - Fall 2024 - Project 4
+// Benchmark suite for the FileSys class. It measures the throughput and the
+// latency distribution of insert, getFile, remove and updateDiskBlock across
+// table sizes, load factors, probing policies and hit/miss ratios, and how each
+// probing policy degrades under skewed, prefix-shared and colliding names.
+// The output follows the Google Benchmark console layout, e.g.
+//     ./filesys_bench --benchmark_filter=GetFile/LINEAR --benchmark_format=csv
+#include "filesys.h"
+#include "random.h"
+#include "latency.h"
+#include "allocator.h"
+#include "hashes.h"
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// the textbook hash of driver.cpp and mytest.cpp, shared through hashes.h
+const hash_fn hashCode = djb33Hash;
+
+const prob_t POLICIES[] = {QUADRATIC, DOUBLEHASH, LINEAR, CUCKOO};
+const int CAPACITIES[] = {MINPRIME, 1009, 10007, MAXPRIME};
+const float LOADS[] = {0.10, 0.25, 0.45};
+const float HITRATIOS[] = {1.0, 0.5, 0.0};
+const int WORKLOADSIZES[] = {1000, 10000};
+
+// Name sets of the workload benchmarks
+enum workload_t {UNIFORMNAMES, UNIFORMFROZEN, ZIPFLOOKUPS, ZIPFCACHED, PREFIXPATHS, COLLIDING, COLLIDINGSEEDED};
+const workload_t WORKLOADS[] = {UNIFORMNAMES, UNIFORMFROZEN, ZIPFLOOKUPS, ZIPFCACHED, PREFIXPATHS, COLLIDING, COLLIDINGSEEDED};
+
+const char* workloadName(workload_t kind){
+    switch (kind) {
+        case UNIFORMNAMES: return "uniform";
+        case UNIFORMFROZEN: return "uniform-frozen";
+        case ZIPFLOOKUPS: return "zipf";
+        case ZIPFCACHED: return "zipf-cached";
+        case PREFIXPATHS: return "prefix";
+        case COLLIDING: return "colliding";
+        case COLLIDINGSEEDED: return "colliding-seeded";
+    }
+    return "unknown";
+}
+
+// Settings taken from the command line.
+struct BenchOptions {
+    string filter;      // only run benchmarks whose name matches this regex
+    long minOps;        // every benchmark repeats until it timed this many operations
+    bool csv;           // print CSV instead of the console table
+    int seed;           // seed for the workload generators
+};
+
+// Generates reproducible sets of unique File objects. Names are random lowercase
+// strings and disk blocks are uniform in [DISKMIN-DISKMAX]; both streams use the
+// fixed seed of the Random class (changed by the --benchmark_seed option).
+class Workload {
+public:
+    Workload(int seed) : m_chars(97, 122), m_length(6, 14), m_blocks(DISKMIN, DISKMAX){
+        m_chars.setSeed(seed);
+        m_length.setSeed(seed + 1);
+        m_blocks.setSeed(seed + 2);
+    }
+    // appends count files that were never generated before by this object
+    void generate(int count, vector<File> & files){
+        while (count > 0) {
+            File file(m_chars.getRandString(m_length.getRandNum()), m_blocks.getRandNum(), true);
+            if (m_seen.insert(make_pair(file.getName(), file.getDiskBlock())).second) {
+                files.push_back(file);
+                count--;
+            }
+        }
+    }
+private:
+    Random m_chars;
+    Random m_length;
+    Random m_blocks;
+    set<pair<string, int> > m_seen;
+};
+
+// Accumulates one benchmark's measurements and prints them as a single row.
+class Reporter {
+public:
+    Reporter(const BenchOptions & options) : m_options(options){}
+    void header(){
+        if (m_options.csv) {
+            cout << "name,iterations,ops,real_time_ns,p50_ns,p90_ns,p99_ns,p999_ns,items_per_second,probes_per_op" << endl;
+            return;
+        }
+#ifndef NDEBUG
+        cout << "***WARNING*** filesys_bench was built without NDEBUG, timings may be affected." << endl;
+#endif
+        cout << string(132, '-') << endl;
+        cout << left << setw(56) << "Benchmark" << right
+             << setw(10) << "Time" << setw(10) << "p50" << setw(10) << "p90"
+             << setw(10) << "p99" << setw(10) << "p99.9" << setw(6) << "Iter" << setw(12) << "items/s"
+             << setw(8) << "probes" << endl;
+        cout << string(132, '-') << endl;
+    }
+    // probes is the average number of buckets inspected per operation, negative if not measured
+    void report(const string & name, int iterations, LatencyStats & latency, long long wallNanos, double probes = -1){
+        double itemsPerSec = LatencyStats::throughput(latency.count(), wallNanos);
+        if (m_options.csv) {
+            cout << name << "," << iterations << "," << latency.count() << ","
+                 << fixed << setprecision(1) << latency.mean() << ","
+                 << latency.percentile(0.50) << "," << latency.percentile(0.90) << ","
+                 << latency.percentile(0.99) << "," << latency.percentile(0.999) << ","
+                 << setprecision(0) << itemsPerSec << ",";
+            if (probes >= 0) cout << setprecision(2) << probes;
+            cout << endl;
+            return;
+        }
+        ostringstream mean;
+        mean << fixed << setprecision(1) << latency.mean() << " ns";
+        ostringstream rate;
+        if (itemsPerSec >= 1e6) rate << fixed << setprecision(2) << itemsPerSec / 1e6 << "M/s";
+        else rate << fixed << setprecision(1) << itemsPerSec / 1e3 << "k/s";
+        cout << left << setw(56) << name << right << setw(10) << mean.str()
+             << setw(10) << latency.percentile(0.50) << setw(10) << latency.percentile(0.90)
+             << setw(10) << latency.percentile(0.99) << setw(10) << latency.percentile(0.999)
+             << setw(6) << iterations << setw(12) << rate.str();
+        if (probes >= 0) cout << setw(8) << fixed << setprecision(1) << probes;
+        cout << endl;
+    }
+private:
+    BenchOptions m_options;
+};
+
+// Builds the benchmark name in the "BM_Op/POLICY/cap:C/load:L" form.
+string benchName(const string & op, prob_t policy, int capacity, float load){
+    ostringstream name;
+    name << "BM_" << op << "/" << policyName(policy) << "/cap:" << capacity
+         << "/load:" << fixed << setprecision(2) << load;
+    return name.str();
+}
+
+// Number of entries that gives the requested load factor in a table of the given capacity.
+int entriesFor(int capacity, float load){
+    return max(1, (int)(capacity * load));
+}
+
+// Timed insertion of the files into a fresh table, repeated until minOps operations.
+// Loads above 0.5 include the rehash work triggered on the way; the /background
+// variant leaves the transfers to the background maintenance thread.
+void benchInsert(Reporter & reporter, const BenchOptions & options, prob_t policy, int capacity, float load, bool background = false){
+    Workload workload(options.seed);
+    vector<File> files;
+    workload.generate(entriesFor(capacity, load), files);
+
+    LatencyStats latency;
+    long long wall = 0;
+    int iterations = 0;
+    while ((long)latency.count() < options.minOps) {
+        FileSys filesys(capacity, hashCode, policy);
+        filesys.setBackgroundMaintenance(background, 200, 200);
+        BenchClock::time_point begin = BenchClock::now();
+        for (size_t i = 0; i < files.size(); i++) {
+            BenchClock::time_point start = BenchClock::now();
+            filesys.insert(files[i]);
+            latency.add(elapsedNanos(start, BenchClock::now()));
+        }
+        wall += elapsedNanos(begin, BenchClock::now());
+        iterations++;
+    }
+    reporter.report(benchName("Insert", policy, capacity, load) + (background ? "/background" : ""), iterations, latency, wall);
+}
+
+// Lookups against a table loaded to the given factor. hitRatio of the queries
+// ask for existing files and the others for files that were never inserted.
+// The /filter variants run the same lookups with the negative lookup filter,
+// the /hugepages variants of the MAXPRIME tables with the table on huge pages.
+void benchGetFile(Reporter & reporter, const BenchOptions & options, prob_t policy, int capacity, float load, float hitRatio, bool filtered, bool hugePages = false){
+    Workload workload(options.seed);
+    vector<File> files;
+    vector<File> missing;
+    workload.generate(entriesFor(capacity, load), files);
+    workload.generate(files.size(), missing);
+
+    HugePageAllocator allocator;
+    FileSys filesys(capacity, hashCode, policy, hugePages ? &allocator : nullptr);
+    filesys.setNegativeFilter(filtered);
+    for (size_t i = 0; i < files.size(); i++) {
+        filesys.insert(files[i]);
+    }
+
+    // the query mix is fixed up front so the timed loop only does lookups
+    Random pick(0, 999);
+    pick.setSeed(options.seed + 3);
+    vector<const File*> queries;
+    for (size_t i = 0; i < files.size(); i++) {
+        bool hit = pick.getRandNum() < (int)(hitRatio * 1000);
+        queries.push_back(hit ? &files[i] : &missing[i]);
+    }
+
+    LatencyStats latency;
+    long long wall = 0;
+    int iterations = 0;
+    int found = 0;
+    while ((long)latency.count() < options.minOps) {
+        BenchClock::time_point begin = BenchClock::now();
+        for (size_t i = 0; i < queries.size(); i++) {
+            BenchClock::time_point start = BenchClock::now();
+            File result = filesys.getFile(queries[i]->getName(), queries[i]->getDiskBlock());
+            latency.add(elapsedNanos(start, BenchClock::now()));
+            found += result.getUsed();
+        }
+        wall += elapsedNanos(begin, BenchClock::now());
+        iterations++;
+    }
+    ostringstream name;
+    name << benchName("GetFile", policy, capacity, load) << "/hit:" << fixed << setprecision(1) << hitRatio;
+    if (filtered) name << "/filter";
+    if (hugePages) name << "/hugepages";
+    reporter.report(name.str(), iterations, latency, wall);
+    if (found < 0) cout << found; // keeps the lookups from being optimized away
+}
+
+// Removes every file of a freshly built table in a shuffled order. The removals
+// past the 0.8 deleted ratio include the rehash they trigger.
+void benchRemove(Reporter & reporter, const BenchOptions & options, prob_t policy, int capacity, float load){
+    Workload workload(options.seed);
+    vector<File> files;
+    workload.generate(entriesFor(capacity, load), files);
+    Random order(0, files.size() - 1, SHUFFLE);
+    order.setSeed(options.seed + 4);
+    vector<int> indices;
+    order.getShuffle(indices);
+
+    LatencyStats latency;
+    long long wall = 0;
+    int iterations = 0;
+    while ((long)latency.count() < options.minOps) {
+        FileSys filesys(capacity, hashCode, policy);
+        for (size_t i = 0; i < files.size(); i++) {
+            filesys.insert(files[i]);
+        }
+        BenchClock::time_point begin = BenchClock::now();
+        for (size_t i = 0; i < indices.size(); i++) {
+            BenchClock::time_point start = BenchClock::now();
+            filesys.remove(files[indices[i]]);
+            latency.add(elapsedNanos(start, BenchClock::now()));
+        }
+        wall += elapsedNanos(begin, BenchClock::now());
+        iterations++;
+    }
+    reporter.report(benchName("Remove", policy, capacity, load), iterations, latency, wall);
+}
+
+// Calls updateDiskBlock for the removed files of a loaded table. updateDiskBlock
+// only changes a deleted entry, so three quarters of the files are removed first
+// (removing more would pass the 0.8 deleted ratio and purge them). Every update
+// must succeed, the benchmark returns false otherwise.
+bool benchUpdateDiskBlock(Reporter & reporter, const BenchOptions & options, prob_t policy, int capacity, float load){
+    Workload workload(options.seed);
+    vector<File> files;
+    workload.generate(entriesFor(capacity, load), files);
+    size_t removed = max((size_t)1, files.size() * 3 / 4);
+    Random blocks(DISKMIN, DISKMAX);
+    blocks.setSeed(options.seed + 5);
+
+    LatencyStats latency;
+    long long wall = 0;
+    int iterations = 0;
+    long failed = 0;
+    while ((long)latency.count() < options.minOps) {
+        FileSys filesys(capacity, hashCode, policy);
+        for (size_t i = 0; i < files.size(); i++) {
+            filesys.insert(files[i]);
+        }
+        for (size_t i = 0; i < removed; i++) {
+            filesys.remove(files[i]);
+        }
+        BenchClock::time_point begin = BenchClock::now();
+        for (size_t i = 0; i < removed; i++) {
+            int block = blocks.getRandNum();
+            BenchClock::time_point start = BenchClock::now();
+            bool updated = filesys.updateDiskBlock(files[i], block);
+            latency.add(elapsedNanos(start, BenchClock::now()));
+            failed += !updated;
+        }
+        wall += elapsedNanos(begin, BenchClock::now());
+        iterations++;
+    }
+    string name = benchName("UpdateDiskBlock", policy, capacity, load);
+    reporter.report(name, iterations, latency, wall);
+    if (failed > 0) {
+        cerr << name << ": " << failed << " of " << latency.count() << " updates missed" << endl;
+    }
+    return failed == 0;
+}
+
+// Creates count files with unused blocks in an empty table. The random variant is
+// the create path without the block allocator: it draws random blocks until it gets
+// one that it has not handed out before. The allocator variant calls createFile,
+// which takes the lowest free block from the table's block allocator.
+void benchCreateFile(Reporter & reporter, const BenchOptions & options, bool allocator, int count){
+    Workload workload(options.seed);
+    vector<File> files;
+    workload.generate(count, files);
+
+    LatencyStats latency;
+    long long wall = 0;
+    int iterations = 0;
+    int created = 0;
+    while ((long)latency.count() < options.minOps) {
+        FileSys filesys(MINPRIME, hashCode, DEFPOLCY);
+        filesys.setBlockAllocator(allocator);
+        Random blocks(DISKMIN, DISKMAX);
+        blocks.setSeed(options.seed + 5);
+        set<int> used;
+        BenchClock::time_point begin = BenchClock::now();
+        for (size_t i = 0; i < files.size(); i++) {
+            BenchClock::time_point start = BenchClock::now();
+            if (allocator) {
+                created += filesys.createFile(files[i].getName()) != -1;
+            }else {
+                int block = blocks.getRandNum();
+                while (!used.insert(block).second or !filesys.insert(File(files[i].getName(), block, true))) {
+                    block = blocks.getRandNum();
+                }
+                created++;
+            }
+            latency.add(elapsedNanos(start, BenchClock::now()));
+        }
+        wall += elapsedNanos(begin, BenchClock::now());
+        iterations++;
+    }
+    ostringstream name;
+    name << "BM_CreateFile/" << (allocator ? "allocator" : "random") << "/n:" << count;
+    reporter.report(name.str(), iterations, latency, wall);
+    if (created < 0) cout << created; // keeps the inserts from being optimized away
+}
+
+// Lookups of existing files in a table filled with one of the name sets:
+//   uniform   - random names, every file looked up equally often
+//   uniform-frozen - the uniform lookups after freeze(), the policy makes no difference
+//   zipf      - the same names, looked up with Zipfian popularity (exponent 1.0)
+//   zipf-cached - the zipf lookups with a front cache of a tenth of the files
+//   prefix    - path names /a/b/c/file_N sharing directory prefixes (depth 3, fanout 4)
+//   colliding - names that all have the same textbook hash value (a tenth of the count),
+//               the flooded chain makes the table switch to the seeded hash on the way
+//   colliding-seeded - the same names in a table that uses the seeded hash from the start
+// The table is sized for a 0.33 load factor so no rehash happens while filling it.
+void benchWorkload(Reporter & reporter, const BenchOptions & options, workload_t kind, prob_t policy, int count){
+    vector<File> files;
+    Random blocks(DISKMIN, DISKMAX);
+    blocks.setSeed(options.seed + 6);
+    if (kind == UNIFORMNAMES or kind == UNIFORMFROZEN or kind == ZIPFLOOKUPS or kind == ZIPFCACHED) {
+        Workload workload(options.seed);
+        workload.generate(count, files);
+    }else if (kind == PREFIXPATHS) {
+        Random paths(0, 1);
+        paths.setSeed(options.seed + 7);
+        for (int i = 0; i < count; i++) {
+            files.push_back(File(paths.getPathName(i, 3, 4), blocks.getRandNum(), true));
+        }
+    }else {
+        Random adversary(0, 1);
+        adversary.setSeed(options.seed + 8);
+        vector<string> names;
+        adversary.getCollidingNames(names, count);
+        for (int i = 0; i < count; i++) {
+            files.push_back(File(names[i], blocks.getRandNum(), true));
+        }
+    }
+
+    FileSys filesys(count * 3, hashCode, policy);
+    if (kind == COLLIDINGSEEDED) {
+        filesys.setSeededHash(true);
+    }
+    if (kind == ZIPFCACHED) {
+        filesys.setFrontCache(count / 10);
+    }
+    for (size_t i = 0; i < files.size(); i++) {
+        filesys.insert(files[i]);
+    }
+    if (kind == UNIFORMFROZEN) {
+        filesys.freeze();
+    }
+
+    // the query order is fixed up front so the timed loop only does lookups
+    vector<const File*> queries;
+    Random pick(0, count - 1, (kind == ZIPFLOOKUPS or kind == ZIPFCACHED) ? ZIPF : UNIFORMINT);
+    pick.setSeed(options.seed + 9);
+    for (int i = 0; i < count; i++) {
+        queries.push_back(&files[pick.getRandNum()]);
+    }
+
+    filesys.resetStats();
+    LatencyStats latency;
+    long long wall = 0;
+    int iterations = 0;
+    int found = 0;
+    while ((long)latency.count() < options.minOps) {
+        BenchClock::time_point begin = BenchClock::now();
+        for (size_t i = 0; i < queries.size(); i++) {
+            BenchClock::time_point start = BenchClock::now();
+            File result = filesys.getFile(queries[i]->getName(), queries[i]->getDiskBlock());
+            latency.add(elapsedNanos(start, BenchClock::now()));
+            found += result.getUsed();
+        }
+        wall += elapsedNanos(begin, BenchClock::now());
+        iterations++;
+    }
+    FileSysStats stats = filesys.getStats();
+    unsigned long long finds = stats.hits[STATFIND] + stats.misses[STATFIND];
+    double probes = finds > 0 ? (double)stats.probeTotal[STATFIND] / finds : -1;
+
+    ostringstream name;
+    name << "BM_Workload/" << workloadName(kind) << "/" << policyName(policy) << "/n:" << count;
+    reporter.report(name.str(), iterations, latency, wall, probes);
+    if (found < 0) cout << found; // keeps the lookups from being optimized away
+}
+
+bool parseOptions(int argc, char** argv, BenchOptions & options){
+    options.filter = ".*";
+    options.minOps = 200000;
+    options.csv = false;
+    options.seed = 10;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg.rfind("--benchmark_filter=", 0) == 0) {
+            options.filter = arg.substr(strlen("--benchmark_filter="));
+        } else if (arg.rfind("--benchmark_min_ops=", 0) == 0) {
+            options.minOps = atol(arg.c_str() + strlen("--benchmark_min_ops="));
+        } else if (arg == "--benchmark_format=csv") {
+            options.csv = true;
+        } else if (arg == "--benchmark_format=console") {
+            options.csv = false;
+        } else if (arg.rfind("--benchmark_seed=", 0) == 0) {
+            options.seed = atoi(arg.c_str() + strlen("--benchmark_seed="));
+        } else {
+            cerr << "usage: " << argv[0] << " [--benchmark_filter=<regex>] [--benchmark_min_ops=<n>]"
+                 << " [--benchmark_format=console|csv] [--benchmark_seed=<n>]" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv){
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) return 1;
+    regex filter(options.filter);
+    Reporter reporter(options);
+    reporter.header();
+    bool ok = true;
+
+    for (prob_t policy : POLICIES) {
+        for (int capacity : CAPACITIES) {
+            for (float load : LOADS) {
+                if (regex_search(benchName("Insert", policy, capacity, load), filter))
+                    benchInsert(reporter, options, policy, capacity, load);
+                for (float hitRatio : HITRATIOS) {
+                    for (bool filtered : {false, true}) {
+                        ostringstream name;
+                        name << benchName("GetFile", policy, capacity, load) << "/hit:" << fixed << setprecision(1) << hitRatio;
+                        if (filtered) name << "/filter";
+                        if (regex_search(name.str(), filter))
+                            benchGetFile(reporter, options, policy, capacity, load, hitRatio, filtered);
+                    }
+                    ostringstream name;
+                    name << benchName("GetFile", policy, capacity, load) << "/hit:" << fixed << setprecision(1) << hitRatio << "/hugepages";
+                    if (capacity == MAXPRIME and regex_search(name.str(), filter))
+                        benchGetFile(reporter, options, policy, capacity, load, hitRatio, false, true);
+                }
+                if (regex_search(benchName("Remove", policy, capacity, load), filter))
+                    benchRemove(reporter, options, policy, capacity, load);
+                if (regex_search(benchName("UpdateDiskBlock", policy, capacity, load), filter))
+                    ok = benchUpdateDiskBlock(reporter, options, policy, capacity, load) and ok;
+            }
+            // growing past the 0.5 load factor measures inserts that pay for rehashing;
+            // at MAXPRIME the table cannot grow any further, so it is left out
+            if (capacity < MAXPRIME and regex_search(benchName("Insert", policy, capacity, 0.9), filter))
+                benchInsert(reporter, options, policy, capacity, 0.9);
+            if (capacity < MAXPRIME and regex_search(benchName("Insert", policy, capacity, 0.9) + "/background", filter))
+                benchInsert(reporter, options, policy, capacity, 0.9, true);
+        }
+    }
+
+    for (bool allocator : {false, true}) {
+        for (int count : WORKLOADSIZES) {
+            ostringstream name;
+            name << "BM_CreateFile/" << (allocator ? "allocator" : "random") << "/n:" << count;
+            if (regex_search(name.str(), filter))
+                benchCreateFile(reporter, options, allocator, count);
+        }
+    }
+
+    for (workload_t kind : WORKLOADS) {
+        for (prob_t policy : POLICIES) {
+            for (int count : WORKLOADSIZES) {
+                // every lookup of a colliding name scans the whole chain, so those sets are smaller
+                if (kind == COLLIDING or kind == COLLIDINGSEEDED) count = count / 10;
+                ostringstream name;
+                name << "BM_Workload/" << workloadName(kind) << "/" << policyName(policy) << "/n:" << count;
+                if (regex_search(name.str(), filter))
+                    benchWorkload(reporter, options, kind, policy, count);
+            }
+        }
+    }
+    return ok ? 0 : 1;
+}
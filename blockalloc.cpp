@@ -0,0 +1,169 @@
+// CMSC 341 - Fall 2024 - Project 4
+#include "blockalloc.h"
+
+BlockAllocator::BlockAllocator():
+m_numFree(NUMBLOCKS)
+{
+    int bits = NUMBLOCKS;
+    for (int level = 0; level < BLOCKLEVELS; level++) {
+        int words = (bits + 63) / 64;
+        // the bits past the end stay clear, so they read as used blocks / full words
+        m_levels[level].assign(words, ~0ULL);
+        if (bits % 64 != 0) {
+            m_levels[level][words - 1] = (1ULL << (bits % 64)) - 1;
+        }
+        bits = words;
+    }
+}
+
+bool BlockAllocator::isFree(int block) const {
+    int position = block - DISKMIN;
+    return (m_levels[0][position / 64] >> (position % 64)) & 1;
+}
+
+void BlockAllocator::acquire(int block) {
+    if (isFree(block)) {
+        setUsed(block - DISKMIN);
+        m_numFree--;
+    }else {
+        m_shared[block]++;
+    }
+}
+
+void BlockAllocator::release(int block) {
+    unordered_map<int, int>::iterator shared = m_shared.find(block);
+    if (shared != m_shared.end()) {
+        if (--shared->second == 0) {
+            m_shared.erase(shared);
+        }
+    }else if (!isFree(block)) {
+        setFree(block - DISKMIN);
+        m_numFree++;
+    }
+}
+
+int BlockAllocator::findFree(int from) const {
+    if (from > DISKMAX) {
+        return -1;
+    }
+    int position = nextSet(0, max(from, DISKMIN) - DISKMIN);
+    return position < 0 ? -1 : DISKMIN + position;
+}
+
+/*
+Jumps from a free block to the first used block after it. A run that is long enough
+is found; otherwise the search continues at the next free block past the used one,
+so every round skips at least one stretch of used blocks.
+*/
+int BlockAllocator::findRun(int count, int from) const {
+    if (count <= 0 or count > NUMBLOCKS or from > DISKMAX) {
+        return -1;
+    }
+    int start = nextSet(0, max(from, DISKMIN) - DISKMIN);
+    while (start >= 0) {
+        int end = nextUsed(start, min(start + count, NUMBLOCKS));
+        if (end - start >= count) {
+            return DISKMIN + start;
+        }
+        start = nextSet(0, end);
+    }
+    return -1;
+}
+
+int BlockAllocator::allocate() {
+    int block = findFree();
+    if (block != -1) {
+        acquire(block);
+    }
+    return block;
+}
+
+int BlockAllocator::allocateRun(int count) {
+    int block = findRun(count);
+    if (block != -1) {
+        for (int i = 0; i < count; i++) {
+            acquire(block + i);
+        }
+    }
+    return block;
+}
+
+size_t BlockAllocator::bytes() const {
+    size_t total = 0;
+    for (int level = 0; level < BLOCKLEVELS; level++) {
+        total += m_levels[level].size() * sizeof(unsigned long long);
+    }
+    return total;
+}
+
+/*
+The word of the position answers the search if it has a set bit at or after the
+position. Otherwise the next level up tells which word to read next.
+*/
+int BlockAllocator::nextSet(int level, int position) const {
+    const vector<unsigned long long> & words = m_levels[level];
+    size_t word = position / 64;
+    if (word >= words.size()) {
+        return -1;
+    }
+    unsigned long long bits = words[word] & (~0ULL << (position % 64));
+    if (bits != 0) {
+        return word * 64 + __builtin_ctzll(bits);
+    }
+    if (level + 1 == BLOCKLEVELS) {
+        // the top level is a few words long
+        for (word++; word < words.size(); word++) {
+            if (words[word] != 0) {
+                return word * 64 + __builtin_ctzll(words[word]);
+            }
+        }
+        return -1;
+    }
+    int next = nextSet(level + 1, word + 1);
+    if (next < 0) {
+        return -1;
+    }
+    return next * 64 + __builtin_ctzll(words[next]);
+}
+
+int BlockAllocator::nextUsed(int position, int limit) const {
+    const vector<unsigned long long> & words = m_levels[0];
+    for (size_t word = position / 64; word < words.size(); word++) {
+        unsigned long long used = ~words[word];
+        if (word == (size_t)position / 64) {
+            used &= ~0ULL << (position % 64);
+        }
+        if (used != 0) {
+            return min(limit, (int)(word * 64 + __builtin_ctzll(used)));
+        }
+        if ((int)(word + 1) * 64 >= limit) {
+            return limit;
+        }
+    }
+    return min(limit, NUMBLOCKS);
+}
+
+void BlockAllocator::setUsed(int position) {
+    for (int level = 0; level < BLOCKLEVELS; level++) {
+        unsigned long long & word = m_levels[level][position / 64];
+        word &= ~(1ULL << (position % 64));
+        // the word still has a free block, the levels above don't change
+        if (word != 0) {
+            return;
+        }
+        position /= 64;
+    }
+}
+
+void BlockAllocator::setFree(int position) {
+    for (int level = 0; level < BLOCKLEVELS; level++) {
+        unsigned long long & word = m_levels[level][position / 64];
+        bool wasFull = (word == 0);
+        word |= 1ULL << (position % 64);
+        // the word had a free block before, the levels above knew about it
+        if (!wasFull) {
+            return;
+        }
+        position /= 64;
+    }
+}
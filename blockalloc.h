@@ -0,0 +1,50 @@
+// CMSC 341 - Fall 2024 - Project 4
+#ifndef BLOCKALLOC_H
+#define BLOCKALLOC_H
+#include "filesys.h"
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+const int NUMBLOCKS = DISKMAX - DISKMIN + 1;
+const int BLOCKLEVELS = 3; // 900000 blocks in 14063 words, summarized by 220 words, summarized by 4 words
+
+// Free disk block map of [DISKMIN-DISKMAX].
+//
+// Level 0 has one bit per block, set while no file holds the block. A bit of
+// level 1 is set while the matching word of level 0 has a free block, and a bit
+// of level 2 while the matching word of level 1 has one. Finding the lowest free
+// block reads one word per level and counts its trailing zeros, instead of trying
+// blocks one at a time. Several files may share a block, the extra holders are
+// counted on the side so the block only turns free when the last one lets it go.
+class BlockAllocator{
+    public:
+    // all blocks start free
+    BlockAllocator();
+    bool isFree(int block) const;
+    // one more file holds the block
+    void acquire(int block);
+    // one file no longer holds the block
+    void release(int block);
+    // returns the lowest free block >= from, -1 if there's none
+    int findFree(int from = DISKMIN) const;
+    // returns the first block of count consecutive free blocks >= from, -1 if there's none
+    int findRun(int count, int from = DISKMIN) const;
+    // findFree and findRun that also acquire the blocks found
+    int allocate();
+    int allocateRun(int count);
+    int numFree() const {return m_numFree;}
+    size_t bytes() const;
+    private:
+    vector<unsigned long long> m_levels[BLOCKLEVELS];
+    unordered_map<int, int> m_shared; // holders beyond the first of the blocks held by several files
+    int m_numFree;
+
+    int nextSet(int level, int position) const; // lowest set bit >= position of a level, -1 if none
+    int nextUsed(int position, int limit) const; // lowest used block offset in [position, limit), limit if none
+    void setUsed(int position);
+    void setFree(int position);
+};
+
+#endif
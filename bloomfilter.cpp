@@ -0,0 +1,72 @@
+// CMSC 341 - Fall 2024 - Project 4
+#include "bloomfilter.h"
+#include <cstring>
+
+CountingBloomFilter::CountingBloomFilter(int buckets):
+m_numCounters(buckets * FILTERCOUNTERS)
+{
+    m_counters = new unsigned char[bytesFor(buckets)];
+    memset(m_counters, 0, bytesFor(buckets));
+}
+
+CountingBloomFilter::~CountingBloomFilter(){
+    delete[] m_counters;
+}
+
+/*
+64 bit FNV-1a of the name with the block mixed in. The two halves drive the
+FILTERHASHES counter positions by double hashing (h1 + i * h2).
+*/
+unsigned long long CountingBloomFilter::hashOf(const string & name, int block){
+    unsigned long long hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < name.size(); i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 1099511628211ULL;
+    }
+    hash = (hash ^ (unsigned int)block) * 1099511628211ULL;
+    return hash ^ (hash >> 29);
+}
+
+int CountingBloomFilter::counter(unsigned int index) const{
+    return (m_counters[index >> 1] >> ((index & 1) * 4)) & 0xf;
+}
+
+void CountingBloomFilter::setCounter(unsigned int index, int value){
+    int shift = (index & 1) * 4;
+    m_counters[index >> 1] = (m_counters[index >> 1] & ~(0xf << shift)) | (value << shift);
+}
+
+void CountingBloomFilter::add(const string & name, int block){
+    unsigned long long hash = hashOf(name, block);
+    unsigned int h1 = (unsigned int)hash, h2 = (unsigned int)(hash >> 32) | 1;
+    for (int i = 0; i < FILTERHASHES; i++) {
+        unsigned int index = (h1 + i * h2) % m_numCounters;
+        int value = counter(index);
+        if (value < 15) {
+            setCounter(index, value + 1);
+        }
+    }
+}
+
+void CountingBloomFilter::remove(const string & name, int block){
+    unsigned long long hash = hashOf(name, block);
+    unsigned int h1 = (unsigned int)hash, h2 = (unsigned int)(hash >> 32) | 1;
+    for (int i = 0; i < FILTERHASHES; i++) {
+        unsigned int index = (h1 + i * h2) % m_numCounters;
+        int value = counter(index);
+        // a saturated counter no longer knows how many pairs it counts
+        if (value > 0 and value < 15) {
+            setCounter(index, value - 1);
+        }
+    }
+}
+
+bool CountingBloomFilter::mayContain(const string & name, int block) const{
+    unsigned long long hash = hashOf(name, block);
+    unsigned int h1 = (unsigned int)hash, h2 = (unsigned int)(hash >> 32) | 1;
+    for (int i = 0; i < FILTERHASHES; i++) {
+        if (counter((h1 + i * h2) % m_numCounters) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+// CMSC 341 - Fall 2024 - Project 4
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+#include <cstddef>
+#include <string>
+using namespace std;
+
+const int FILTERCOUNTERS = 8; // counters per table bucket
+const int FILTERHASHES = 3;   // counters set per (name, block)
+
+// Counting Bloom filter over the (name, block) pairs of one FileSys table.
+//
+// Every pair in the table sets FILTERHASHES of its 4 bit counters, so a pair
+// with a zero counter is certainly not in the table and its search can stop
+// before touching the table. With 8 counters per bucket and the table at most
+// half full, about 1 in 200 missing pairs still has to be searched. Counters
+// make it possible to take a pair out again when its entry is overwritten;
+// a counter that reaches 15 stays there, which only costs false positives.
+class CountingBloomFilter{
+    public:
+    // sized for a table of the given number of buckets
+    CountingBloomFilter(int buckets);
+    ~CountingBloomFilter();
+    void add(const string & name, int block);
+    void remove(const string & name, int block);
+    // returns false if the pair is certainly not in the table
+    bool mayContain(const string & name, int block) const;
+    size_t bytes() const {return bytesFor(m_numCounters / FILTERCOUNTERS);}
+    static size_t bytesFor(int buckets) {return (size_t)buckets * FILTERCOUNTERS / 2;}
+    private:
+    unsigned char* m_counters;   // two 4 bit counters per byte
+    unsigned int   m_numCounters;
+
+    static unsigned long long hashOf(const string & name, int block);
+    int counter(unsigned int index) const;
+    void setCounter(unsigned int index, int value);
+};
+
+#endif
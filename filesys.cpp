@@ -1,21 +1,89 @@
 // CMSC 341 - Fall 2024 - Project 4
 #include "filesys.h"
+#include "trace.h"
+#include "hashes.h"
+#include "allocator.h"
+#include "frontcache.h"
+#include "bloomfilter.h"
+#include "blockalloc.h"
+#include "frozen.h"
+#include <new>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
-FileSys::FileSys(int size, hash_fn hash, prob_t probing = DEFPOLCY):
+// The thread of setBackgroundMaintenance(true) and what it shares with the table operations.
+struct MaintenanceThread{
+    std::thread thread;
+    std::recursive_mutex lock;      // held by every table operation and by the thread while it works
+    std::condition_variable_any wake;
+    bool stop;
+    int budgetMicros;               // work per run
+    int intervalMicros;             // pause between runs
+};
+
+// Holds the maintenance lock for one table operation, if maintenance is on. The lock is
+// recursive since rehash transfers the entries through insert.
+class MaintenanceGuard{
+    public:
+    MaintenanceGuard(MaintenanceThread* maintenance) : m_maintenance(maintenance){
+        if (m_maintenance != nullptr) m_maintenance->lock.lock();
+    }
+    ~MaintenanceGuard(){
+        if (m_maintenance != nullptr) m_maintenance->lock.unlock();
+    }
+    private:
+    MaintenanceThread* m_maintenance;
+};
+
+FileSys::FileSys(int size, hash_fn hash, prob_t probing = DEFPOLCY, TableAllocator* allocator):
 m_hash(hash),            // Initialized to hash function provided
 m_newPolicy(probing),   // Initialized to default (QUADRATIC) as there's no change yet
+m_newSeeded(false),     // Initialized to the user hash function
 m_currentTable(nullptr), // Placeholder - will be set after adjusting size
 m_currentCap(size),         // Placeholder - will be set after adjusting size
 m_currentSize(0),        // Initialized to zero number of entries
 m_currNumDeleted(0),     // Initialized to zero number of deleted entries
 m_currProbing(probing),  // Initialized to collision handling policy provided
+m_currSeeded(false),     // Initialized to the user hash function
 m_oldTable(nullptr),     // Initialized to nullptr as there's no old hash table initially
 m_oldCap(0),             // Initialized to zero as there's no old hash table initially
 m_oldSize(0),            // Initialized to zero as there's no old hash table initially
 m_oldNumDeleted(0),      // Initialized to zero as there's no old hash table initially
 m_oldProbing(probing),  // Initialized to default (QUADRATIC) as there's no change yet
-m_transferIndex(-1)     // Initialized to -1 as there's no incremental transfer yet
+m_oldSeeded(false),     // Initialized to the user hash function
+m_transferIndex(-1),    // Initialized to -1 as there's no incremental transfer yet
+m_moving(false),         // Initialized to false as no entry is being transferred
+m_adaptive(false),       // Initialized to false as the policy is fixed by default
+m_lastProbes(0),         // Initialized to zero as nothing has been searched yet
+m_adaptOps(0),           // Initialized to zero as nothing has been sampled yet
+m_adaptProbes(0),        // Initialized to zero as nothing has been sampled yet
+m_probeCount(0),         // Initialized to zero as no operation is in progress
+m_trace(nullptr),        // Initialized to nullptr as nothing is recorded by default
+m_index(nullptr),        // Initialized to nullptr as the ordered index is optional
+m_cache(nullptr),        // Initialized to nullptr as the front cache is optional
+m_currFilter(nullptr),   // Initialized to nullptr as the negative lookup filter is optional
+m_oldFilter(nullptr),    // Initialized to nullptr as there's no old hash table initially
+m_blocks(nullptr),       // Initialized to nullptr as the block allocator is optional
+m_frozen(nullptr),       // Initialized to nullptr as the table starts out writable
+m_maintenance(nullptr),  // Initialized to nullptr as the background maintenance is optional
+m_floodDetected(false),  // Initialized to false as no chain has been probed yet
+m_forceRehash(false),    // Initialized to false as no rehash is requested
+m_reseeded(false),       // Initialized to false as no rehash has happened yet
+m_allocator(allocator),  // Initialized to the allocator provided, nullptr for new and delete
+m_footprint(0)           // Initialized to zero as nothing is allocated yet
 {
+    m_currSeed[0] = m_currSeed[1] = 0;
+    m_oldSeed[0] = m_oldSeed[1] = 0;
+    memset(&m_stats, 0, sizeof(m_stats)); // Initialized to zero as nothing has been counted yet
+
     // "If the user passes a size less than MINPRIME, the capacity must be set to MINPRIME."
     if (size < MINPRIME){
         size = MINPRIME;
@@ -32,209 +100,639 @@ m_transferIndex(-1)     // Initialized to -1 as there's no incremental transfer
     m_currentCap = size;
 
     // Allocating memory for the current table
-    m_currentTable = new File*[m_currentCap](); // Allocating the array of pointer
-    for (int i = 0; i < m_currentCap; i++) {
-        m_currentTable[i] = nullptr; // Allocating a file object for each pointer
-    }
+    m_currentTable = allocTable(m_currentCap); // Allocating the array of pointers, all set to nullptr
 }
 
 FileSys::~FileSys(){
+    setBackgroundMaintenance(false);
+    detachSnapshots();
     // Deallocating memory for current table and old table
-    if (m_currentTable != nullptr){
-        for (int i = 0; i < m_currentCap; i++) {
-            delete m_currentTable[i];  // delete each File object
-            m_currentTable[i] = nullptr;
+    freeTable(m_currentTable, m_currentCap);
+    freeTable(m_oldTable, m_oldCap);
+    delete m_index;
+    delete m_cache;
+    freeFilter(m_currFilter);
+    freeFilter(m_oldFilter);
+    delete m_blocks;
+    delete m_frozen;
+}
+
+void FileSys::changeProbPolicy(prob_t policy){
+    MaintenanceGuard guard(m_maintenance);
+    m_newPolicy = policy;
+}
+
+void FileSys::setAdaptivePolicy(bool enabled){
+    MaintenanceGuard guard(m_maintenance);
+    m_adaptive = enabled;
+    m_adaptOps = 0;
+    m_adaptProbes = 0;
+}
+
+/*
+Every live file of the current table is placed in an empty table of the capacity a
+rehash would pick, with the policy, by the hash cached in its slot. The cost of a file
+is the search that finds it there: a probe per inspected bucket, and ADAPTLINECOST more
+for each bucket in a cache line the search hasn't touched yet, which is what makes a
+LINEAR walk through a cluster cheaper than the same number of scattered probes.
+A seeded table gets a new seed from the rehash, the estimate is still close since
+SipHash values are spread the same way for any seed.
+*/
+prob_t FileSys::suggestPolicy() const {
+    MaintenanceGuard guard(m_maintenance);
+    int live = m_currentSize - m_currNumDeleted;
+    if (live == 0 or m_currProbing == CUCKOO or m_frozen != nullptr) {
+        return m_currProbing;
+    }
+    int capacity = findNextPrime(4 * live);
+    prob_t best = m_currProbing;
+    float current = policyCost(m_currProbing, capacity);
+    float bestCost = current;
+    prob_t policies[] = {LINEAR, QUADRATIC, DOUBLEHASH};
+    for (int p = 0; p < 3; p++) {
+        if (policies[p] != m_currProbing) {
+            float cost = policyCost(policies[p], capacity);
+            if (cost < ADAPTGAIN * current and cost < bestCost) {
+                best = policies[p];
+                bestCost = cost;
+            }
         }
-        delete[] m_currentTable; // delete the array of pointers
-        m_currentTable = nullptr;
     }
-    if (m_oldTable != nullptr){
-        for (int i = 0; i < m_oldCap; i++) {
-            delete m_oldTable[i];  // delete each File object
-            m_oldTable[i] = nullptr;
+    return best;
+}
+
+bool FileSys::adaptPolicy(){
+    MaintenanceGuard guard(m_maintenance);
+    if (m_oldTable != nullptr or m_moving) {
+        return false; // the entries are on their way to a table already
+    }
+    prob_t best = suggestPolicy();
+    if (best == m_currProbing) {
+        return false;
+    }
+    FS_STAT(m_stats.policyChanges++);
+    changeProbPolicy(best);
+    m_forceRehash = true;
+    rehash();
+    return true;
+}
+
+float FileSys::policyCost(prob_t policy, int capacity) const {
+    vector<bool> taken(capacity, false);
+    long long cost = 0;
+    int live = 0;
+    for (int i = 0; i < m_currentCap; i++) {
+        if (!m_currentTable[i].occupied() or !m_currentTable[i].getUsed()) {
+            continue;
+        }
+        unsigned int hash = m_currentTable[i].getHash();
+        int origIndex = hash % capacity; // The same walk as searchForFile
+        int currIndex = origIndex;
+        int collisionAmt = 0;
+        long long lastLine = -1;
+        while (true) {
+            long long line = (long long)origIndex * sizeof(Slot) / 64;
+            cost += (line == lastLine) ? 1 : 1 + ADAPTLINECOST;
+            lastLine = line;
+            if (!taken[origIndex]) {
+                break;
+            }
+            switch (policy) {
+                case LINEAR:
+                    origIndex = (currIndex + collisionAmt) % capacity;
+                    break;
+                case QUADRATIC:
+                    origIndex = (currIndex + (collisionAmt * collisionAmt)) % capacity;
+                    break;
+                default:
+                    int stepSize = hash % (capacity - 1) + 1;
+                    origIndex = (currIndex + (collisionAmt * stepSize)) % capacity;
+                    break;
+            }
+            collisionAmt++;
         }
-        delete[] m_oldTable; // delete the array of pointers
-        m_oldTable = nullptr;
+        taken[origIndex] = true;
+        live++;
     }
+    return live > 0 ? (float)cost / live : 0;
 }
 
-void FileSys::changeProbPolicy(prob_t policy){
-    m_newPolicy = policy;
+void FileSys::sampleProbes() const {
+    m_adaptOps++;
+    m_adaptProbes += m_lastProbes;
+}
+
+/*
+The window is at least as long as the table, so the O(capacity) estimate of
+suggestPolicy costs each sampled operation a constant share.
+*/
+bool FileSys::checkAdaptive() {
+    if (m_adaptOps < (unsigned long long)max(ADAPTWINDOW, m_currentCap)) {
+        return false;
+    }
+    float average = (float)m_adaptProbes / m_adaptOps;
+    m_adaptOps = 0;
+    m_adaptProbes = 0;
+    if (average > ADAPTPROBES) {
+        return adaptPolicy();
+    }
+    return false;
+}
+
+void FileSys::setSeededHash(bool seeded){
+    MaintenanceGuard guard(m_maintenance);
+    m_newSeeded = seeded;
+    if (m_currentSize == 0 and m_oldTable == nullptr) {
+        // nothing is hashed yet, the table can switch in place
+        m_currSeeded = seeded;
+        if (seeded) {
+            newSeed(m_currSeed);
+        }
+    }else if (seeded != m_currSeeded) {
+        // the entries must be rehashed with the new hash function
+        m_forceRehash = true;
+        rehash();
+    }
 }
 
 bool FileSys::insert(File file) {
+    MaintenanceGuard guard(m_maintenance);
+    // inserts done by rehash are counted as moved entries rather than as operations
+    FS_STAT(bool transferring = m_moving);
+    if (m_trace != nullptr and !m_moving) {
+        m_trace->record(TRACEINSERT, file.getName(), file.getDiskBlock());
+    }
+    FS_STAT(m_probeCount = 0);
+    // A frozen table is read-only
+    if (m_frozen != nullptr) {
+        FS_STAT(recordOp(STATINSERT, false));
+        return false;
+    }
     // Checking First Constraint = file's block number value should be within valid range
     if (file.getDiskBlock() < DISKMIN or file.getDiskBlock() > DISKMAX){
+        FS_STAT(recordOp(STATINSERT, false));
         return false;
     }
     // Checking Second Constraint = table isn't full
     if (m_currentSize >= m_currentCap){
+        FS_STAT(recordOp(STATINSERT, false));
         return false;
     }
     // Checking Third Constraint = file object isn't a duplicate object
-    const File* foundFile = searchForFile(file, m_currentTable, m_currentCap, m_currProbing);
+    const Slot* foundFile = searchForFile(file, m_currentTable, m_currentCap, m_currProbing);
+    if (m_adaptive and !m_moving) {
+        sampleProbes();
+    }
+    // (so is a live file in the old table that the background transfer hasn't moved yet)
+    if (foundFile == nullptr and m_oldTable != nullptr and !m_moving) {
+        const Slot* oldFile = searchForFile(file, m_oldTable, m_oldCap, m_oldProbing);
+        if (oldFile != nullptr and oldFile->getUsed()) {
+            foundFile = oldFile;
+        }
+    }
+    // Checking Fourth Constraint = the allocator has room for the name and the rehash it triggers
+    // (the names transferred by rehash were accounted for before the rehash started)
+    if (foundFile == nullptr and m_allocator != nullptr and !m_moving) {
+        size_t bytes = nameBytes(file.m_name.size());
+        if ((float)(m_currentSize + 1 - m_currNumDeleted) / m_currentCap > 0.5) {
+            bytes += rehashBytes();
+        }
+        if (!m_allocator->canAllocate(bytes)) {
+            FS_STAT(recordOp(STATINSERT, false));
+            return false;
+        }
+    }
     if (foundFile == nullptr) {
         if (insertFile(file, m_currentTable, m_currentCap, m_currProbing)) {
             m_currentSize++;
+            FS_STAT(if (transferring) m_stats.entriesMoved++; else recordOp(STATINSERT, true));
+            // entries moved by rehash are in the index and hold their blocks already
+            if (m_index != nullptr and !m_moving) {
+                m_index->insert(make_pair(file.m_name, file.getDiskBlock()));
+            }
+            if (m_blocks != nullptr and !m_moving) {
+                m_blocks->acquire(file.getDiskBlock());
+            }
             // Checking If Rehashing Is Needed:
-            if (lambda() > 0.5) {
-                rehash(m_currentTable);
+            // a flooded probe chain changes to a new seed, once until the next regular rehash.
+            // m_newSeeded stays set after that rehash: the flooding names are still in the
+            // table, and the next rehash back to the user hash would only rebuild their chain
+            // and reseed again. setSeededHash(false) is the way back to the user hash.
+            if (m_floodDetected and !m_reseeded and !m_moving) {
+                m_newSeeded = true;
+                m_forceRehash = true;
+                FS_STAT(m_stats.reseedCount++);
             }
+            // (the transfer's own inserts never rehash; with the background maintenance the new
+            // table can pass 0.5 before the transfer is done, the next operation rehashes then)
+            if ((lambda() > 0.5 or m_forceRehash) and !m_moving) {
+                rehash();
+            }else if ((float)m_currentSize / m_currentCap > OCCUPIEDMAX and !m_moving) {
+                // the deleted entries take buckets too, a search over a table without
+                // an empty bucket on its probe sequence would never end
+                if (purgeFits()) {
+                    purgeDeleted();
+                }else {
+                    rehash();
+                }
+            }
+            if (m_adaptive and !m_moving) {
+                checkAdaptive();
+            }
+        }else {
+            // a CUCKOO table that had no room for the file even after its rebuilds
+            FS_STAT(if (!transferring) recordOp(STATINSERT, false));
+            return false;
         }
         return true;
     }else{
+        FS_STAT(if (!transferring) recordOp(STATINSERT, false));
         return false;
     }
 }
 
 /*
-Preconditions = load factor > 50% or deleted ratio > 80%.
+Preconditions = load factor > 50%, deleted ratio > 80% or occupied buckets (deleted entries
+included) > OCCUPIEDMAX.
 Function performs the following tasks:
 1. Store Current Data in Old Table: 
     Saves the current table's details (size, capacity, deleted entries) to be used for 
-    the rehashing process. The current table's entries are deep copied over to Old Table.
+    the rehashing process. The current table itself becomes the Old Table, the slots
+    hold their entries by value so nothing has to be copied.
 2. Empty Current Table Entries: 
-    Current hash table is emptied so it can be rehashed. 
+    A new empty current table is allocated so the entries can be rehashed into it. 
 3. Update Current Table: 
     New Capacity is the smallest prime greater than four times the current number of 
     occupied buckets (rehash excludes deleted entries). If a policy has changed, then 
-    this function will rehash with the new policy.
+    this function will rehash with the new policy. A seeded table gets a new random seed.
+    A rehash can also be forced (m_forceRehash) to change the hash function or the seed.
 4. Transfer Live Data By 25% Portions & Reset Transfer Index: 
     Copies live data (non-deleted entries) from the old table to the current table in 
     25% portions, rehashing the entries to fit the current table. Once all data is 
-    transferred, reset m_transferIndex.
+    transferred, reset m_transferIndex. With the background maintenance on, the
+    transfer is left to the maintenance thread and rehash returns right away.
 5. Delete & Deallocate Old Table: 
     "Once all data is transferred to the new table, the old table will be removed,
     and its memory will be deallocated."
+A transfer still in progress is finished first.
 */
-void FileSys::rehash(File ** &table) { 
-    if (lambda() > 0.5 or deletedRatio() > 0.8){
-        // After all data is transferred, Delete & Deallocate Old Table:
-        for (int i = 0; i < m_oldCap; i++) {
-            delete m_oldTable[i];  // delete each File object
-            m_oldTable[i] = nullptr;
+void FileSys::rehash() {
+    if (lambda() > 0.5 or deletedRatio() > 0.8 or (float)m_currentSize / m_currentCap > OCCUPIEDMAX or m_forceRehash){
+        // a rehash forced by a flooded chain allows no other reseed until the next rehash
+        m_reseeded = m_forceRehash and m_floodDetected;
+        m_forceRehash = false;
+        // the snapshots take their pages before the table is moved away
+        detachSnapshots();
+        FS_STAT(std::chrono::steady_clock::time_point rehashStart = std::chrono::steady_clock::now());
+        FS_STAT(m_stats.rehashCount++);
+        // A transfer left to the maintenance thread has to be finished first
+        // (m_oldTable is already nullptr once a previous rehash has completed)
+        if (m_oldTable != nullptr) {
+            transfer(-1);
         }
-        delete[] m_oldTable; // delete the array of pointers
-        m_oldTable = nullptr;
 
         // Store Current Table Data in Old Table
         m_oldCap = m_currentCap;
         m_oldSize = m_currentSize;
         m_oldNumDeleted = m_currNumDeleted;
         m_oldProbing = m_currProbing;
+        m_oldSeeded = m_currSeeded;
+        m_oldSeed[0] = m_currSeed[0];
+        m_oldSeed[1] = m_currSeed[1];
         
-        m_oldTable = new File*[m_oldCap];
-        for (int i = 0; i < m_oldCap; i++) {
-            if (m_currentTable[i] != nullptr) {
-                // Perform Deep Copy of Current File Entry
-                m_oldTable[i] = new File(*(m_currentTable[i])); // Copy File object
-            }else{
-                m_oldTable[i] = nullptr;
-            }
-        }
-        
-        // Empty Current Table Entries
-        if (m_currentTable != nullptr){
-            for (int i = 0; i < m_currentCap; i++) {
-                delete m_currentTable[i];  // delete each File object
-                m_currentTable[i] = nullptr;
-            }
-            delete[] m_currentTable; // delete the array of pointers
-            m_currentTable = nullptr;
+        // Move the current table over to the old one
+        // (the front cache points into the current table, so it starts over)
+        if (m_cache != nullptr) {
+            m_cache->clear();
         }
+        m_oldTable = m_currentTable;
+        m_currentTable = nullptr;
+        freeFilter(m_oldFilter);
+        m_oldFilter = m_currFilter;
+        m_currFilter = nullptr;
+
         // Empty Current Table Entries & Update Current Table
         m_currentCap = findNextPrime(4 * (m_currentSize - m_currNumDeleted));
-        m_currentTable = new File*[m_currentCap]();
+        m_currentTable = allocTable(m_currentCap);
+        if (m_oldFilter != nullptr) {
+            m_currFilter = buildFilter(m_currentTable, m_currentCap); // filled by the transfer
+        }
         m_currentSize = 0;
         m_currNumDeleted = 0;
+        // a name with more files than its CUCKOO buckets hold keeps the table on its policy
+        if (m_newPolicy == CUCKOO and m_oldProbing != CUCKOO and !cuckooFits(m_oldTable, m_oldCap)) {
+            m_newPolicy = m_oldProbing;
+        }
         m_currProbing = m_newPolicy;
+        m_currSeeded = m_newSeeded;
+        if (m_currSeeded) {
+            newSeed(m_currSeed);
+        }
 
         // Transfer Live Data By 25% Portions & Reset Transfer Index
         m_transferIndex = 0; // tells us incremental transfer begins
-        int transferLimit = floor(m_oldCap / 4);
-        bool allTransfered = false; // Boolean flag indicating whether or not all data has been transferred.
-        while (!allTransfered){
-            for (int i = m_transferIndex; i < min(m_transferIndex + transferLimit, m_oldCap); i++) {
-                if (m_oldTable[i] != nullptr and m_oldTable[i]->getUsed()) { // If the entry is not deleted
-                    insert(*m_oldTable[i]); // Rehash and insert into the updated current table
-                }
+        if (m_maintenance == nullptr) {
+            transfer(-1);
+        }
+        FS_STAT(m_stats.rehashNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - rehashStart).count());
+    }
+}
+
+/*
+Transfers the live entries of the old table from m_transferIndex on, in 25% portions,
+and frees the old table once all of them are in the current table. A budget of
+budgetNanos >= 0 stops the transfer after the portion that used it up, with portions
+of TRANSFERSTEP buckets so a run of the maintenance thread stays short; the rest is
+left for the next call. Returns true when the old table is gone.
+
+A moved entry is marked deleted in the old table, so the table operations that look
+at both tables between two calls see each file once.
+*/
+bool FileSys::transfer(long long budgetNanos) {
+    if (m_oldTable == nullptr) {
+        return true;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int transferLimit = budgetNanos < 0 ? max(1, m_oldCap / 4) : TRANSFERSTEP;
+    bool allTransfered = false; // Boolean flag indicating whether or not all data has been transferred.
+    while (!allTransfered){
+        m_moving = true;
+        for (int i = m_transferIndex; i < min(m_transferIndex + transferLimit, m_oldCap); i++) {
+            if (m_oldTable[i].occupied() and m_oldTable[i].getUsed()) { // If the entry is not deleted
+                insert(m_oldTable[i].toFile()); // Rehash and insert into the updated current table
+                m_oldTable[i].setUsed(false);
             }
+        }
+        m_moving = false;
+
+        // Update the transfer index after the portion is transferred.
+        m_transferIndex += transferLimit;
+
+        // If all data has been transferred, update allTransfered
+        if (m_transferIndex >= m_oldCap){
+            allTransfered = true;
+        }else if (budgetNanos >= 0 and std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now() - start).count() >= budgetNanos) {
+            return false;
+        }
+    }
+
+    // After all data is transferred, Delete & Deallocate Old Table:
+    freeTable(m_oldTable, m_oldCap);
+    freeFilter(m_oldFilter);
+    m_transferIndex = -1; // tells us there's no more incremental transfer
+    m_floodDetected = false; // chains found while transferring were probed with the new seed
+    return true;
+}
+
+/*
+A rehash for the deleted ratio alone would build a table of about the same size,
+so the deleted entries are cleared in place instead, unless the table would
+shrink to less than a quarter of its capacity, a rehash is in progress, or the
+next table is to have another policy or seed.
+*/
+bool FileSys::purgeFits() const {
+    if (m_oldTable != nullptr or m_forceRehash or m_currProbing != m_newPolicy or m_currSeeded != m_newSeeded) {
+        return false;
+    }
+    return lambda() <= 0.5 and findNextPrime(4 * (m_currentSize - m_currNumDeleted)) > m_currentCap / 4;
+}
 
-            // Update the transfer index after the portion is transferred.
-            m_transferIndex += transferLimit;
+/*
+Clears the deleted entries of the current table without allocating a new one and
+without calling the hash function, every slot caches its hash. A CUCKOO table only
+empties the buckets: a file is always in one of its two buckets or the stash.
 
-            // If all data has been transferred, update allTransfered
-            if (m_transferIndex >= m_oldCap){
-                allTransfered = true;
+A probe chain ends at an empty bucket, so once the deleted entries are gone the live
+ones after them could no longer be found. First every deleted entry is emptied and
+every live entry is marked pending. Then each pending entry walks its probe sequence
+to the first bucket that is empty or pending: it stays if that is its own bucket,
+moves if the bucket is empty, and swaps with the entry there if it is pending, which
+is then placed the same way from the bucket it was swapped into. Every placed entry
+is reached from its home bucket over placed entries only, the same walk searchForFile
+does, and the table never holds more than half of its capacity, so a quadratic
+sequence always finds a bucket.
+*/
+void FileSys::purgeDeleted() {
+    FS_STAT(m_stats.purgeCount++);
+    // nearly every bucket may move
+    detachSnapshots();
+    // the front cache points into the table
+    if (m_cache != nullptr) {
+        m_cache->clear();
+    }
+    Slot* table = m_currentTable;
+    int capacity = m_currentCap;
+    for (int i = 0; i < capacity; i++) {
+        if (table[i].occupied()) {
+            if (!table[i].getUsed()) {
+                dropDeleted(table, i);
+            }else if (m_currProbing != CUCKOO) {
+                table[i].m_word |= SLOTPENDING;
             }
         }
+    }
 
-        // After all data is transferred, Delete & Deallocate Old Table:
-        for (int i = 0; i < m_oldCap; i++) {
-            delete m_oldTable[i];  // delete each File object
-            m_oldTable[i] = nullptr;
+    for (int i = 0; i < capacity; i++) {
+        while (table[i].m_word & SLOTPENDING) {
+            unsigned int hash = table[i].getHash();
+            int origIndex = hash % capacity; // The same walk as searchForFile, from the home bucket
+            int currIndex = origIndex;
+            int collisionAmt = 0;
+            while (table[origIndex].occupied() and !(table[origIndex].m_word & SLOTPENDING)) {
+                switch (m_currProbing) {
+                    case LINEAR:
+                        origIndex = (currIndex + collisionAmt) % capacity;
+                        break;
+                    case QUADRATIC:
+                        origIndex = (currIndex + (collisionAmt * collisionAmt)) % capacity;
+                        break;
+                    default:
+                        int stepSize = hash % (capacity - 1) + 1;
+                        origIndex = (currIndex + (collisionAmt * stepSize)) % capacity;
+                        break;
+                }
+                collisionAmt++;
+            }
+            if (origIndex == i) {
+                table[i].m_word &= ~SLOTPENDING; // already where a search finds it
+            }else if (!table[origIndex].occupied()) {
+                table[origIndex] = table[i]; // the long name moves with the slot
+                table[origIndex].m_word &= ~SLOTPENDING;
+                table[i].m_word = 0;
+            }else {
+                swap(table[i], table[origIndex]);
+                table[origIndex].m_word &= ~SLOTPENDING;
+            }
         }
-        delete[] m_oldTable; // delete the array of pointers
-        m_oldTable = nullptr;
-        m_transferIndex = -1; // tells us there's no more incremental transfer
     }
 }
 
 bool FileSys::remove(File file) {
+    MaintenanceGuard guard(m_maintenance);
+    bool wasLive = false; // removing a deleted entry again succeeds too, but it holds no block
+    if (m_trace != nullptr) {
+        m_trace->record(TRACEREMOVE, file.getName(), file.getDiskBlock());
+    }
+    FS_STAT(m_probeCount = 0);
+    if (m_frozen != nullptr) {
+        FS_STAT(recordOp(STATREMOVE, false));
+        return false;
+    }
+    if (m_cache != nullptr) {
+        m_cache->invalidate(file.m_name, file.getDiskBlock());
+    }
     // Try to remove file in current table
-    if (removeFile(file, m_currentTable, m_currentCap, m_currProbing)) {
-        m_currNumDeleted++;
+    if (removeFile(file, m_currentTable, m_currentCap, m_currProbing, wasLive)) {
+        // (an entry deleted already is counted once)
+        if (wasLive) {
+            m_currNumDeleted++;
+        }
+        FS_STAT(recordOp(STATREMOVE, true));
+        if (m_index != nullptr) {
+            m_index->erase(make_pair(file.m_name, file.getDiskBlock()));
+        }
+        if (m_blocks != nullptr and wasLive) {
+            m_blocks->release(file.getDiskBlock());
+        }
 
-        // Check if need to rehash
+        // Check if need to rehash, or only to clear the deleted entries
         if (deletedRatio() > 0.8) {
-            rehash(m_currentTable);
+            if (purgeFits()) {
+                purgeDeleted();
+            }else {
+                rehash();
+            }
+        }
+        if (m_adaptive) {
+            checkAdaptive();
         }
         return true;
     }
 
     // Try to remove file in old table
-    if (m_oldTable != nullptr and m_transferIndex < m_oldSize and removeFile(file, m_oldTable, m_oldCap, m_oldProbing)) {
-        m_oldNumDeleted++;
+    if (m_oldTable != nullptr and removeFile(file, m_oldTable, m_oldCap, m_oldProbing, wasLive)) {
+        if (wasLive) {
+            m_oldNumDeleted++;
+        }
+        FS_STAT(recordOp(STATREMOVE, true));
+        if (m_index != nullptr) {
+            m_index->erase(make_pair(file.m_name, file.getDiskBlock()));
+        }
+        if (m_blocks != nullptr and wasLive) {
+            m_blocks->release(file.getDiskBlock());
+        }
 
         // Check if need to rehash
         if (deletedRatio() > 0.8) {
-            rehash(m_oldTable);
+            rehash();
         }
         return true;
     }
+    FS_STAT(recordOp(STATREMOVE, false));
     return false;
 }
 
 const File FileSys::getFile(string name, int block) const {
+    MaintenanceGuard guard(m_maintenance);
     File file(name, block); // File object with name and file block number to search for.
+    if (m_trace != nullptr) {
+        m_trace->record(TRACEGETFILE, name, block);
+    }
+    FS_STAT(m_probeCount = 0);
+
+    // A frozen table answers with the one position of the perfect hash
+    if (m_frozen != nullptr) {
+        FS_STAT(m_probeCount = 1);
+        bool found = m_frozen->find(name, block) != -1;
+        FS_STAT(recordOp(STATFIND, found));
+        return found ? File(name, block, true) : File();
+    }
+
+    // 0. Asks The Front Cache, it only holds live files of the current table
+    if (m_cache != nullptr) {
+        const Slot* cachedFile = m_cache->find(name, block);
+        if (cachedFile != nullptr) {
+            FS_STAT(recordOp(STATFIND, true));
+            return cachedFile->toFile();
+        }
+    }
 
     // 1. Searches For File In Current Table
-    const File* foundFile = searchForFile(file, m_currentTable, m_currentCap, m_currProbing);
+    const Slot* foundFile = searchForFile(file, m_currentTable, m_currentCap, m_currProbing);
+    if (m_adaptive) {
+        sampleProbes();
+    }
     if (foundFile != nullptr) {
-        return *foundFile;
+        FS_STAT(recordOp(STATFIND, true));
+        if (m_cache != nullptr and foundFile->getUsed()) {
+            m_cache->add(name, block, foundFile);
+        }
+        return foundFile->toFile();
     }
 
     // 2. Searches For File In Current Table
     if (m_oldTable != nullptr) {
         foundFile = searchForFile(file, m_oldTable, m_oldCap, m_oldProbing);
         if (foundFile != nullptr) {
-            return *foundFile;
+            FS_STAT(recordOp(STATFIND, true));
+            return foundFile->toFile();
         }
     }
+    FS_STAT(recordOp(STATFIND, false));
     return File();
 }
 
+vector<int> FileSys::findAll(string name) const {
+    MaintenanceGuard guard(m_maintenance);
+    vector<int> blocks;
+    FS_STAT(m_probeCount = 0);
+    // the perfect hash needs the block, a frozen table keeps its files sorted by name for this
+    if (m_frozen != nullptr) {
+        int reads = 0;
+        m_frozen->findAll(name, blocks, reads);
+        FS_STAT(m_probeCount += reads);
+    }
+    collectBlocks(name, m_currentTable, m_currentCap, m_currProbing, blocks);
+    if (m_oldTable != nullptr) {
+        collectBlocks(name, m_oldTable, m_oldCap, m_oldProbing, blocks);
+    }
+    // a probe sequence can visit a bucket twice (the first probe is the home bucket again),
+    // and a live (name, block) pair is unique, so repeated blocks are the same file
+    sort(blocks.begin(), blocks.end());
+    blocks.erase(unique(blocks.begin(), blocks.end()), blocks.end());
+    FS_STAT(recordOp(STATFIND, !blocks.empty()));
+    return blocks;
+}
+
 bool FileSys::updateDiskBlock(File file, int block){
-    if (updateFile(file, m_currentTable, m_currentCap, m_currProbing, block)) {
-        return true;
+    MaintenanceGuard guard(m_maintenance);
+    if (m_trace != nullptr) {
+        m_trace->record(TRACEUPDATE, file.getName(), file.getDiskBlock(), block);
     }
-    if (m_oldTable != nullptr and updateFile(file, m_oldTable, m_oldCap, m_oldProbing, block)) {
-        return true;
+    FS_STAT(m_probeCount = 0);
+    // the new block must be within valid range, a slot has room for [DISKMIN-DISKMAX] only
+    if (block < DISKMIN or block > DISKMAX or m_frozen != nullptr) {
+        FS_STAT(recordOp(STATUPDATE, false));
+        return false;
     }
-    return false;
+    // a deleted entry changed to (name, block) would come before a live one on its chain
+    if (m_cache != nullptr) {
+        m_cache->invalidate(file.m_name, block);
+    }
+    bool updated = updateFile(file, m_currentTable, m_currentCap, m_currProbing, block)
+                   or (m_oldTable != nullptr and updateFile(file, m_oldTable, m_oldCap, m_oldProbing, block));
+    FS_STAT(recordOp(STATUPDATE, updated));
+    // getFile can't rehash, a window the lookups filled is checked by the next change
+    if (m_adaptive) {
+        checkAdaptive();
+    }
+    return updated;
 }
 
 float FileSys::lambda() const {
+    MaintenanceGuard guard(m_maintenance);
     float loadFactor = 0.0;
     if (m_currentCap > 0) {
         loadFactor = (float)(m_currentSize - m_currNumDeleted) / m_currentCap;
@@ -243,6 +741,7 @@ float FileSys::lambda() const {
 }
 
 float FileSys::deletedRatio() const {
+    MaintenanceGuard guard(m_maintenance);
     float ratio = 0.0;
     if (m_currentSize > 0) {
         ratio = (float)m_currNumDeleted / m_currentSize;
@@ -253,17 +752,40 @@ float FileSys::deletedRatio() const {
 /*
 This is a helper function that looks for the File object in the specified table.
 */
-const File* FileSys::searchForFile(const File & file, File** table, int capacity, prob_t probing) const{
+const Slot* FileSys::searchForFile(const File & file, Slot* table, int capacity, prob_t probing) const{
     // Build hash value
-    int origIndex = m_hash(file.getName()) % capacity; // The inital index of file to be inserted. Determined by applying the hash function m_hash and then reducing the output of the hash function modulo the table size.
+    unsigned int hash = tableHash(file.m_name, table); // The hash value of the name in this table (m_hash or the seeded hash)
+    int origIndex = hash % capacity; // The inital index of file to be inserted. Determined by applying the hash function m_hash and then reducing the output of the hash function modulo the table size.
     int currIndex = origIndex; // Altered index of file based on probing policy. Initialzed to original index.
     int collisionAmt = 0; // Amount of collisions at the current index.
+    int foreignProbes = 0; // Amount of probed entries with a different name.
+    // A missing file is usually ruled out by the filter without probing
+    const CountingBloomFilter* filter = filterOf(table);
+    if (filter != nullptr and !filter->mayContain(file.m_name, file.getDiskBlock())) {
+        FS_STAT(m_stats.filterNegatives++);
+        m_lastProbes = 0;
+        return nullptr;
+    }
+    // A CUCKOO table has two candidate buckets instead of a probe chain
+    if (probing == CUCKOO) {
+        m_lastProbes = 1;
+        const Slot* foundFile = cuckooFind(file, hash, table, capacity);
+        FS_STAT(if (foundFile == nullptr and filter != nullptr) m_stats.filterFalsePositives++);
+        return foundFile;
+    }
 
-    while (table[origIndex] != nullptr) {
-        // Find file match
-        if (table[origIndex]->getName() == file.getName()
-        and table[origIndex]->getDiskBlock() == file.getDiskBlock()) {
-            return table[origIndex];
+    while (table[origIndex].occupied()) {
+        FS_STAT(m_probeCount++);
+        FS_STAT(if (!table[origIndex].getUsed()) m_stats.tombstonesTraversed++);
+        // Find file match, the cached hash rules out most other names without reading them
+        if (table[origIndex].getHash() == hash and table[origIndex].nameEquals(file.m_name)) {
+            if (table[origIndex].getDiskBlock() == file.getDiskBlock()) {
+                m_lastProbes = collisionAmt + 1;
+                return &table[origIndex];
+            }
+        }else if (++foreignProbes > FLOODPROBES) {
+            // only entries of other names make the chain suspicious, a name can have many blocks
+            m_floodDetected = true;
         }
 
         // Increment the probe index based on the current probing policy
@@ -274,29 +796,127 @@ const File* FileSys::searchForFile(const File & file, File** table, int capacity
             case QUADRATIC:
                 origIndex = (currIndex + (collisionAmt * collisionAmt)) % capacity;
                 break;
+            case CUCKOO: // a CUCKOO table is searched by its buckets before the probe loop
             case DOUBLEHASH:
-                int stepSize = m_hash(file.getName()) % (capacity - 1) + 1;
+                int stepSize = hash % (capacity - 1) + 1;
                 origIndex = (currIndex + (collisionAmt * stepSize)) % capacity;
                 break;
         }
         collisionAmt++;
     }
+    FS_STAT(m_probeCount++); // the empty bucket that ends the search
+    FS_STAT(if (filter != nullptr) m_stats.filterFalsePositives++);
+    m_lastProbes = collisionAmt + 1;
     return nullptr;    
 }
 
+/*
+This is a helper function that adds the disk blocks of the live files with the name in the
+specified table to blocks. The probe sequence depends on the name only, so every file with
+the name is on the chain that starts at the name's home bucket and ends at an empty bucket;
+in a CUCKOO table they are in the name's two buckets or the stash.
+*/
+void FileSys::collectBlocks(const string & name, Slot* table, int capacity, prob_t probing, vector<int> & blocks) const{
+    // Build hash value
+    unsigned int hash = tableHash(name, table); // The hash value of the name in this table (m_hash or the seeded hash)
+    int origIndex = hash % capacity; // The inital index of the name's chain.
+    int currIndex = origIndex; // Altered index of file based on probing policy. Initialzed to original index.
+    int collisionAmt = 0; // Amount of collisions at the current index.
+    int foreignProbes = 0; // Amount of probed entries with a different name.
+
+    if (probing == CUCKOO) {
+        int first, second;
+        cuckooBuckets(hash, capacity, first, second);
+        int stash = (capacity - CUCKOOSTASH) / CUCKOOSLOTS * CUCKOOSLOTS;
+        int starts[3] = {first * CUCKOOSLOTS, second * CUCKOOSLOTS, stash};
+        int ends[3] = {(first + 1) * CUCKOOSLOTS, (second + 1) * CUCKOOSLOTS, capacity};
+        for (int b = 0; b < 3; b++) {
+            FS_STAT(m_probeCount++);
+            for (int i = starts[b]; i < ends[b]; i++) {
+                if (table[i].occupied() and table[i].getUsed() and table[i].getHash() == hash and table[i].nameEquals(name)) {
+                    blocks.push_back(table[i].getDiskBlock());
+                }
+            }
+        }
+        return;
+    }
+
+    while (table[origIndex].occupied()) {
+        FS_STAT(m_probeCount++);
+        FS_STAT(if (!table[origIndex].getUsed()) m_stats.tombstonesTraversed++);
+        // Collect live files with the name
+        if (table[origIndex].getHash() == hash and table[origIndex].nameEquals(name)) {
+            if (table[origIndex].getUsed()) {
+                blocks.push_back(table[origIndex].getDiskBlock());
+            }
+        }else if (++foreignProbes > FLOODPROBES) {
+            m_floodDetected = true;
+        }
+
+        // Increment the probe index based on the current probing policy
+        switch (probing) {
+            case LINEAR:
+                origIndex = (currIndex + collisionAmt) % capacity;
+                break;
+            case QUADRATIC:
+                origIndex = (currIndex + (collisionAmt * collisionAmt)) % capacity;
+                break;
+            case CUCKOO: // a CUCKOO table is searched by its buckets before the probe loop
+            case DOUBLEHASH:
+                int stepSize = hash % (capacity - 1) + 1;
+                origIndex = (currIndex + (collisionAmt * stepSize)) % capacity;
+                break;
+        }
+        collisionAmt++;
+    }
+    FS_STAT(m_probeCount++); // the empty bucket that ends the chain
+}
+
 /*
 This is a helper function that looks for the File object in the specified table and updates its disk block.
 */
-bool FileSys::updateFile(const File & file, File** table, int capacity, prob_t probing, int block){
+bool FileSys::updateFile(const File & file, Slot* table, int capacity, prob_t probing, int block){
     // Build hash value
-    int origIndex = m_hash(file.getName()) % capacity; // The inital index of file to be inserted. Determined by applying the hash function m_hash and then reducing the output of the hash function modulo the table size.
+    unsigned int hash = tableHash(file.m_name, table); // The hash value of the name in this table (m_hash or the seeded hash)
+    int origIndex = hash % capacity; // The inital index of file to be inserted. Determined by applying the hash function m_hash and then reducing the output of the hash function modulo the table size.
     int currIndex = origIndex; // Altered index of file based on probing policy. Initialzed to original index.
     int collisionAmt = 0; // Amount of collisions at the current index.
 
-    while (table[origIndex] != nullptr) {
+    // A missing file is usually ruled out by the filter without probing
+    if (filterOf(table) != nullptr and !filterOf(table)->mayContain(file.m_name, file.getDiskBlock())) {
+        FS_STAT(m_stats.filterNegatives++);
+        return false;
+    }
+
+    // The buckets of a CUCKOO file depend on its name only, it keeps its slot
+    if (probing == CUCKOO) {
+        Slot* slot = cuckooFind(file, hash, table, capacity);
+        if (slot == nullptr or slot->getUsed()) {
+            return false;
+        }
+        preserve(table, slot - table);
+        slot->setDiskBlock(block);
+        CountingBloomFilter* filter = filterOf(table);
+        if (filter != nullptr) {
+            filter->remove(file.m_name, file.getDiskBlock());
+            filter->add(file.m_name, block);
+        }
+        return true;
+    }
+
+    while (table[origIndex].occupied()) {
+        FS_STAT(m_probeCount++);
+        FS_STAT(if (!table[origIndex].getUsed()) m_stats.tombstonesTraversed++);
         // Find file match
-        if (*(table[origIndex]) == file and !table[origIndex]->getUsed()) {
-            table[origIndex]->setDiskBlock(block);
+        if (table[origIndex].getDiskBlock() == file.getDiskBlock() and table[origIndex].getHash() == hash
+            and table[origIndex].nameEquals(file.m_name) and !table[origIndex].getUsed()) {
+            preserve(table, origIndex);
+            table[origIndex].setDiskBlock(block);
+            CountingBloomFilter* filter = filterOf(table);
+            if (filter != nullptr) {
+                filter->remove(file.m_name, file.getDiskBlock());
+                filter->add(file.m_name, block);
+            }
             return true;
         }
 
@@ -308,29 +928,54 @@ bool FileSys::updateFile(const File & file, File** table, int capacity, prob_t p
             case QUADRATIC:
                 origIndex = (currIndex + (collisionAmt * collisionAmt)) % capacity;
                 break;
+            case CUCKOO: // a CUCKOO table is searched by its buckets before the probe loop
             case DOUBLEHASH:
-                int stepSize = m_hash(file.getName()) % (capacity - 1) + 1;
+                int stepSize = hash % (capacity - 1) + 1;
                 origIndex = (currIndex + (collisionAmt * stepSize)) % capacity;
                 break;
         }
         collisionAmt++;
     }
+    FS_STAT(m_probeCount++); // the empty bucket that ends the search
     return false;    
 }
 
 /*
 This is a helper function that looks for the File object in the specified table and sets m_used to false.
 */
-bool FileSys::removeFile(const File & file, File** table, int capacity, prob_t probing){
+bool FileSys::removeFile(const File & file, Slot* table, int capacity, prob_t probing, bool & wasLive){
     // Build hash value
-    int origIndex = m_hash(file.getName()) % capacity; // The inital index of file to be inserted. Determined by applying the hash function m_hash and then reducing the output of the hash function modulo the table size.
+    unsigned int hash = tableHash(file.m_name, table); // The hash value of the name in this table (m_hash or the seeded hash)
+    int origIndex = hash % capacity; // The inital index of file to be inserted. Determined by applying the hash function m_hash and then reducing the output of the hash function modulo the table size.
     int currIndex = origIndex; // Altered index of file based on probing policy. Initialzed to original index.
     int collisionAmt = 0; // Amount of collisions at the current index.
 
-    while (table[origIndex] != nullptr) {
+    // A missing file is usually ruled out by the filter without probing
+    if (filterOf(table) != nullptr and !filterOf(table)->mayContain(file.m_name, file.getDiskBlock())) {
+        FS_STAT(m_stats.filterNegatives++);
+        return false;
+    }
+
+    if (probing == CUCKOO) {
+        Slot* slot = cuckooFind(file, hash, table, capacity);
+        if (slot == nullptr) {
+            return false;
+        }
+        wasLive = slot->getUsed();
+        preserve(table, slot - table);
+        slot->setUsed(false);
+        return true;
+    }
+
+    while (table[origIndex].occupied()) {
+        FS_STAT(m_probeCount++);
+        FS_STAT(if (!table[origIndex].getUsed()) m_stats.tombstonesTraversed++);
         // Find file match
-        if (*(table[origIndex]) == file) {
-            table[origIndex]->setUsed(false);
+        if (table[origIndex].getDiskBlock() == file.getDiskBlock() and table[origIndex].getHash() == hash
+            and table[origIndex].nameEquals(file.m_name)) {
+            wasLive = table[origIndex].getUsed();
+            preserve(table, origIndex);
+            table[origIndex].setUsed(false);
             return true;
         }
 
@@ -342,30 +987,69 @@ bool FileSys::removeFile(const File & file, File** table, int capacity, prob_t p
             case QUADRATIC:
                 origIndex = (currIndex + (collisionAmt * collisionAmt)) % capacity;
                 break;
+            case CUCKOO: // a CUCKOO table is searched by its buckets before the probe loop
             case DOUBLEHASH:
-                int stepSize = m_hash(file.getName()) % (capacity - 1) + 1;
+                int stepSize = hash % (capacity - 1) + 1;
                 origIndex = (currIndex + (collisionAmt * stepSize)) % capacity;
                 break;
         }
         collisionAmt++;
     }
+    FS_STAT(m_probeCount++); // the empty bucket that ends the search
     return false;    
 }
 
 /*
 This is a helper function that inserts file in the specified table, if found, and sets m_used to true.
 */
-bool FileSys::insertFile(const File & file, File** table, int capacity, prob_t probing){
+bool FileSys::insertFile(const File & file, Slot* table, int capacity, prob_t probing){
     // Build hash value
-    int origIndex = m_hash(file.getName()) % capacity; // The inital index of file to be inserted. Determined by applying the hash function m_hash and then reducing the output of the hash function modulo the table size.
+    unsigned int hash = tableHash(file.m_name, table); // The hash value of the name in this table (m_hash or the seeded hash)
+    int origIndex = hash % capacity; // The inital index of file to be inserted. Determined by applying the hash function m_hash and then reducing the output of the hash function modulo the table size.
     int currIndex = origIndex; // Altered index of file based on probing policy. Initialzed to original index.
     int collisionAmt = 0; // Amount of collisions at the current index.
+    int foreignProbes = 0; // Amount of probed entries with a different name.
+
+    if (probing == CUCKOO) {
+        if (cuckooFind(file, hash, table, capacity) != nullptr) {
+            return false;
+        }
+        // the files of a name share two buckets with other names, a name gets one bucket's worth
+        vector<int> blocks;
+        collectBlocks(file.m_name, table, capacity, CUCKOO, blocks);
+        if (blocks.size() >= (size_t)CUCKOONAMEMAX) {
+            return false;
+        }
+        int index = cuckooPlace(hash, table, capacity);
+        // no room left, the current table is rebuilt larger (a transfer only inserts into it)
+        if (index < 0 and table == m_currentTable and cuckooGrow()) {
+            table = m_currentTable;
+            capacity = m_currentCap;
+            hash = tableHash(file.m_name, table);
+            index = cuckooPlace(hash, table, capacity);
+        }
+        if (index < 0) {
+            return false;
+        }
+        FS_STAT(m_probeCount++); // the bucket that receives the file
+        if (filterOf(table) != nullptr) {
+            filterOf(table)->add(file.m_name, file.getDiskBlock());
+        }
+        preserve(table, index);
+        fillSlot(table[index], file, hash);
+        return true;
+    }
 
-    while (table[origIndex] != nullptr and table[origIndex]->getUsed()) {
+    while (table[origIndex].occupied() and table[origIndex].getUsed()) {
+        FS_STAT(m_probeCount++);
         // Find file match
-        if (*(table[origIndex]) == file) {
+        bool sameName = table[origIndex].getHash() == hash and table[origIndex].nameEquals(file.m_name);
+        if (sameName and table[origIndex].getDiskBlock() == file.getDiskBlock()) {
             return false;
         }
+        if (!sameName and ++foreignProbes > FLOODPROBES) {
+            m_floodDetected = true;
+        }
 
         // Increment the probe index based on the current probing policy
         switch (probing) {
@@ -375,25 +1059,38 @@ bool FileSys::insertFile(const File & file, File** table, int capacity, prob_t p
             case QUADRATIC:
                 origIndex = (currIndex + (collisionAmt * collisionAmt)) % capacity;
                 break;
+            case CUCKOO: // a CUCKOO table is searched by its buckets before the probe loop
             case DOUBLEHASH:
-                int stepSize = m_hash(file.getName()) % (capacity - 1) + 1;
+                int stepSize = hash % (capacity - 1) + 1;
                 origIndex = (currIndex + (collisionAmt * stepSize)) % capacity;
                 break;
         }
         collisionAmt++;
     }
 
-    //insert file
-    if (table[origIndex] == nullptr) {
-        table[origIndex] = new File(file);
-    }else {
-        *table[origIndex] = file;
+    FS_STAT(m_probeCount++); // the bucket that receives the file
+
+    //insert file, a deleted entry in the bucket is overwritten
+    preserve(table, origIndex);
+    if (table[origIndex].occupied()) {
+        dropDeleted(table, origIndex);
+    }
+    if (filterOf(table) != nullptr) {
+        filterOf(table)->add(file.m_name, file.getDiskBlock());
     }
-    table[origIndex]->setUsed(true);
+    fillSlot(table[origIndex], file, hash);
     return true;    
 }
 
 void FileSys::dump() const {
+    MaintenanceGuard guard(m_maintenance);
+    if (m_frozen != nullptr) {
+        cout << "Dump for the frozen table: " << endl;
+        for (int i = 0; i < m_frozen->size(); i++) {
+            File file(m_frozen->nameAt(i), m_frozen->blockAt(i), true);
+            cout << "[" << i << "] : " << &file << endl;
+        }
+    }
     cout << "Dump for the current table: " << endl;
     if (m_currentTable != nullptr)
         for (int i = 0; i < m_currentCap; i++) {
@@ -406,7 +1103,1055 @@ void FileSys::dump() const {
         }
 }
 
-bool FileSys::isPrime(int number){
+/*
+This is a helper function that adds the operation which just finished to the statistics.
+m_probeCount holds the number of buckets the operation inspected in both tables.
+*/
+void FileSys::recordOp(stat_op_t op, bool hit) const {
+    int bucket = 0;
+    while (bucket < PROBEBUCKETS - 1 and m_probeCount > (1 << bucket)) {
+        bucket++;
+    }
+    m_stats.probeHistogram[op][bucket]++;
+    m_stats.probeTotal[op] += m_probeCount;
+    if (hit) {
+        m_stats.hits[op]++;
+    }else {
+        m_stats.misses[op]++;
+    }
+}
+
+/*
+This is a helper function that returns the heap bytes a name of the given length
+needs: nothing if it fits in the slot, its length otherwise.
+*/
+size_t FileSys::nameBytes(size_t length) {
+    return length > SLOTINLINE ? length : 0;
+}
+
+FileSysStats FileSys::getStats() const {
+    MaintenanceGuard guard(m_maintenance);
+    FileSysStats stats = m_stats;
+    FS_STAT(stats.bytesInUse = m_footprint);
+    if (m_cache != nullptr) {
+        FS_STAT(stats.cacheHits = m_cache->hits());
+        FS_STAT(stats.cacheMisses = m_cache->misses());
+        FS_STAT(stats.cacheEvictions = m_cache->evictions());
+    }
+    return stats;
+}
+
+void FileSys::resetStats() {
+    MaintenanceGuard guard(m_maintenance);
+    memset(&m_stats, 0, sizeof(m_stats));
+    if (m_cache != nullptr) {
+        m_cache->resetCounters();
+    }
+}
+
+ostream& StatFamilies::family(string name, string help, string type) {
+    for (unsigned int i = 0; i < m_names.size(); i++) {
+        if (m_names[i] == name) {
+            return m_samples[i];
+        }
+    }
+    m_names.push_back(name);
+    m_headers.push_back("# HELP " + name + " " + help + "\n# TYPE " + name + " " + type + "\n");
+    m_samples.emplace_back();
+    return m_samples.back();
+}
+
+void StatFamilies::write(ostream& out) const {
+    for (unsigned int i = 0; i < m_names.size(); i++) {
+        out << m_headers[i] << m_samples[i].str();
+    }
+}
+
+void FileSys::writeStats(ostream& out, string labels) const {
+    StatFamilies families;
+    collectStats(families, labels);
+    families.write(out);
+}
+
+void FileSys::collectStats(StatFamilies& families, string labels) const {
+    MaintenanceGuard guard(m_maintenance);
+    const char* opNames[NUMSTATOPS] = {"insert", "remove", "find", "update"};
+    string extra = labels.empty() ? "" : "," + labels;   // labels after the metric's own labels
+    string only = labels.empty() ? "" : "{" + labels + "}"; // labels of a metric without its own
+
+    ostream& probes = families.family("filesys_probe_length", "Buckets inspected per operation.", "histogram");
+    for (int op = 0; op < NUMSTATOPS; op++) {
+        unsigned long long cumulative = 0;
+        for (int bucket = 0; bucket < PROBEBUCKETS; bucket++) {
+            cumulative += m_stats.probeHistogram[op][bucket];
+            probes << "filesys_probe_length_bucket{op=\"" << opNames[op] << "\",le=\"";
+            if (bucket < PROBEBUCKETS - 1) probes << (1 << bucket);
+            else probes << "+Inf";
+            probes << "\"" << extra << "} " << cumulative << endl;
+        }
+        probes << "filesys_probe_length_sum{op=\"" << opNames[op] << "\"" << extra << "} " << m_stats.probeTotal[op] << endl;
+        probes << "filesys_probe_length_count{op=\"" << opNames[op] << "\"" << extra << "} " << cumulative << endl;
+    }
+    ostream& ops = families.family("filesys_operations_total", "Operations by type and result.", "counter");
+    for (int op = 0; op < NUMSTATOPS; op++) {
+        ops << "filesys_operations_total{op=\"" << opNames[op] << "\",result=\"hit\"" << extra << "} " << m_stats.hits[op] << endl;
+        ops << "filesys_operations_total{op=\"" << opNames[op] << "\",result=\"miss\"" << extra << "} " << m_stats.misses[op] << endl;
+    }
+    families.family("filesys_tombstones_traversed_total", "Deleted buckets skipped while probing.", "counter")
+        << "filesys_tombstones_traversed_total" << only << " " << m_stats.tombstonesTraversed << endl;
+    families.family("filesys_rehash_total", "Rehash operations.", "counter")
+        << "filesys_rehash_total" << only << " " << m_stats.rehashCount << endl;
+    families.family("filesys_rehash_seconds_total", "Time spent rehashing.", "counter")
+        << "filesys_rehash_seconds_total" << only << " " << m_stats.rehashNanos / 1e9 << endl;
+    families.family("filesys_purge_total", "Purges that cleared the deleted entries in place.", "counter")
+        << "filesys_purge_total" << only << " " << m_stats.purgeCount << endl;
+    families.family("filesys_rehash_entries_moved_total", "Live entries transferred by rehash.", "counter")
+        << "filesys_rehash_entries_moved_total" << only << " " << m_stats.entriesMoved << endl;
+    families.family("filesys_reseed_total", "Rehashes done to change the hash seed after a flooded chain.", "counter")
+        << "filesys_reseed_total" << only << " " << m_stats.reseedCount << endl;
+    families.family("filesys_bytes_in_use", "Heap bytes held by the tables and their entries.", "gauge")
+        << "filesys_bytes_in_use" << only << " " << getStats().bytesInUse << endl;
+    families.family("filesys_bytes_allocated_total", "Heap bytes allocated by the tables and their entries.", "counter")
+        << "filesys_bytes_allocated_total" << only << " " << m_stats.bytesAllocated << endl;
+    if (m_cache != nullptr) {
+        FileSysStats stats = getStats();
+        ostream& lookups = families.family("filesys_front_cache_lookups_total", "getFile calls by front cache result.", "counter");
+        lookups << "filesys_front_cache_lookups_total{result=\"hit\"" << extra << "} " << stats.cacheHits << endl;
+        lookups << "filesys_front_cache_lookups_total{result=\"miss\"" << extra << "} " << stats.cacheMisses << endl;
+        families.family("filesys_front_cache_evictions_total", "Files dropped by the front cache to make room.", "counter")
+            << "filesys_front_cache_evictions_total" << only << " " << stats.cacheEvictions << endl;
+    }
+    if (m_currFilter != nullptr) {
+        families.family("filesys_filter_negatives_total", "Searches the negative lookup filter ended without probing.", "counter")
+            << "filesys_filter_negatives_total" << only << " " << m_stats.filterNegatives << endl;
+        families.family("filesys_filter_false_positives_total", "Searches the filter let through that found nothing.", "counter")
+            << "filesys_filter_false_positives_total" << only << " " << m_stats.filterFalsePositives << endl;
+    }
+    if (m_maintenance != nullptr) {
+        families.family("filesys_maintenance_runs_total", "Runs of the background maintenance that found work to do.", "counter")
+            << "filesys_maintenance_runs_total" << only << " " << m_stats.maintenanceRuns << endl;
+        families.family("filesys_maintenance_seconds_total", "Time the background maintenance spent working.", "counter")
+            << "filesys_maintenance_seconds_total" << only << " " << m_stats.maintenanceNanos / 1e9 << endl;
+    }
+    if (m_adaptive) {
+        families.family("filesys_policy_changes_total", "Rehashes the adaptive policy did to change the probing policy.", "counter")
+            << "filesys_policy_changes_total" << only << " " << m_stats.policyChanges << endl;
+    }
+    families.family("filesys_load_factor", "Load factor of the current table.", "gauge")
+        << "filesys_load_factor" << only << " " << lambda() << endl;
+    families.family("filesys_deleted_ratio", "Ratio of deleted buckets in the current table.", "gauge")
+        << "filesys_deleted_ratio" << only << " " << deletedRatio() << endl;
+}
+
+bool FileSys::exportStats(string filename) const {
+    ofstream out(filename.c_str());
+    if (!out) {
+        return false;
+    }
+    writeStats(out);
+    return (bool)out;
+}
+
+size_t FileSys::footprint() const {
+    MaintenanceGuard guard(m_maintenance);
+    return m_footprint;
+}
+
+/*
+The peak of additional memory a rehash needs right now. The current table becomes
+the old one as it is, the new table is allocated next to it and the long names
+are copied into it before the old table is freed. The long names of deleted
+entries are counted too, which keeps the estimate on the safe side.
+*/
+size_t FileSys::rehashBytes() const {
+    MaintenanceGuard guard(m_maintenance);
+    size_t live = m_currentSize - m_currNumDeleted;
+    size_t newCap = findNextPrime(4 * live);
+    size_t filterBytes = m_currFilter != nullptr ? m_currFilter->bytes() : 0;
+    size_t longNames = m_footprint - m_currentCap * sizeof(Slot) - filterBytes;
+    size_t newFilterBytes = m_currFilter != nullptr ? CountingBloomFilter::bytesFor(newCap) : 0;
+    return newCap * sizeof(Slot) + newFilterBytes + longNames;
+}
+
+bool FileSys::wantsGrow() const {
+    MaintenanceGuard guard(m_maintenance);
+    return lambda() >= GROWLOAD and findNextPrime(4 * (m_currentSize - m_currNumDeleted)) > m_currentCap;
+}
+
+bool FileSys::rehashNow() {
+    MaintenanceGuard guard(m_maintenance);
+    if (m_allocator != nullptr and !m_allocator->canAllocate(rehashBytes())) {
+        return false;
+    }
+    m_forceRehash = true;
+    rehash();
+    return true;
+}
+
+/*
+This is a helper function that allocates a table of the given capacity with every
+bucket empty, from the allocator if there is one.
+*/
+Slot* FileSys::allocTable(int capacity) {
+    size_t bytes = capacity * sizeof(Slot);
+    Slot* table;
+    if (m_allocator != nullptr) {
+        table = (Slot*)m_allocator->allocate(bytes);
+    }else {
+        table = new Slot[capacity];
+    }
+    memset(table, 0, bytes); // a zero word is an empty bucket
+    m_footprint += bytes;
+    FS_STAT(m_stats.bytesAllocated += bytes);
+    return table;
+}
+
+/*
+This is a helper function that deallocates a table and the long names of its entries,
+and sets the table to nullptr.
+*/
+void FileSys::freeTable(Slot*& table, int capacity) {
+    if (table == nullptr) {
+        return;
+    }
+    for (int i = 0; i < capacity; i++) {
+        freeName(table[i]); // delete each long name
+    }
+    if (m_allocator != nullptr) {
+        m_allocator->deallocate(table, capacity * sizeof(Slot));
+    }else {
+        delete[] table; // delete the array of slots
+    }
+    table = nullptr;
+    m_footprint -= capacity * sizeof(Slot);
+}
+
+/*
+This is a helper function that stores a live file in an empty slot: the block and the
+hash value are packed into the word, the name goes inline or into a new heap buffer.
+*/
+void FileSys::fillSlot(Slot & slot, const File & file, unsigned int hash) {
+    size_t length = file.m_name.size();
+    slot.m_word = ((unsigned long long)hash << SLOTHASHSHIFT) | SLOTOCCUPIED | SLOTUSED
+                | (unsigned long long)(file.getDiskBlock() - DISKMIN);
+    if (length <= (size_t)SLOTINLINE) {
+        slot.m_word |= (unsigned long long)length << SLOTLENGTHSHIFT;
+        memcpy(slot.m_inline, file.m_name.data(), length);
+    }else {
+        char* data;
+        if (m_allocator != nullptr) {
+            data = (char*)m_allocator->allocate(length);
+        }else {
+            data = new char[length];
+        }
+        memcpy(data, file.m_name.data(), length);
+        slot.m_word |= SLOTLONGNAME;
+        slot.m_heap.data = data;
+        slot.m_heap.length = length;
+        m_footprint += nameBytes(length);
+        FS_STAT(m_stats.bytesAllocated += nameBytes(length));
+    }
+}
+
+void FileSys::freeName(Slot & slot) {
+    if (slot.occupied() and slot.isLongName()) {
+        size_t length = slot.m_heap.length;
+        if (m_allocator != nullptr) {
+            m_allocator->deallocate(slot.m_heap.data, length);
+        }else {
+            delete[] slot.m_heap.data;
+        }
+        m_footprint -= nameBytes(length);
+        slot.m_word &= ~SLOTLONGNAME;
+        slot.m_heap.data = nullptr;
+    }
+}
+
+/*
+This is a helper function that empties a bucket holding a deleted entry so a file can
+take it. The entry no longer counts as a deleted entry or towards the table size;
+without that, reused buckets were counted twice and a table at a low load factor
+could report itself full.
+*/
+void FileSys::dropDeleted(Slot* table, int index) {
+    preserve(table, index);
+    if (filterOf(table) != nullptr) {
+        filterOf(table)->remove(table[index].getName(), table[index].getDiskBlock());
+    }
+    freeName(table[index]);
+    table[index].m_word = 0;
+    if (table == m_currentTable) {
+        m_currentSize--;
+        m_currNumDeleted--;
+    }else {
+        m_oldSize--;
+        m_oldNumDeleted--;
+    }
+}
+
+/*
+This is a helper function that returns the two candidate buckets of a name in a CUCKOO
+table. They are drawn from the hash value of the name only, so every file of a name is in
+the same two buckets or the stash, which is all findAll reads; the block tells the files
+of a name apart within them. From the hash value cached in a slot, the buckets of a
+stored file are found again without reading its name.
+*/
+void FileSys::cuckooBuckets(unsigned int hash, int capacity, int & first, int & second) {
+    int numBuckets = (capacity - CUCKOOSTASH) / CUCKOOSLOTS;
+    // the 64 bit finalizer of MurmurHash3 over the name's hash value
+    unsigned long long key = ((unsigned long long)hash << 32) | hash;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    first = (int)((key >> 32) % numBuckets);
+    second = (int)((key & 0xffffffffULL) % numBuckets);
+    if (second == first) {
+        second = (first + 1) % numBuckets;
+    }
+}
+
+/*
+This is a helper function that looks for the file in a CUCKOO table: the slots of its name's
+two buckets, then the stash at the end of the table. A file is always in one of them, a table
+that has no room left for one is rebuilt (see cuckooGrow).
+*/
+Slot* FileSys::cuckooFind(const File & file, unsigned int hash, Slot* table, int capacity) const {
+    int block = file.getDiskBlock();
+    int first, second;
+    cuckooBuckets(hash, capacity, first, second);
+    int buckets[2] = {first, second};
+    for (int b = 0; b < 2; b++) {
+        FS_STAT(m_probeCount++);
+        Slot* bucket = table + buckets[b] * CUCKOOSLOTS;
+        for (int i = 0; i < CUCKOOSLOTS; i++) {
+            FS_STAT(if (bucket[i].occupied() and !bucket[i].getUsed()) m_stats.tombstonesTraversed++);
+            if (bucket[i].occupied() and bucket[i].getDiskBlock() == block and bucket[i].getHash() == hash
+                and bucket[i].nameEquals(file.m_name)) {
+                return &bucket[i];
+            }
+        }
+    }
+    int stash = (capacity - CUCKOOSTASH) / CUCKOOSLOTS * CUCKOOSLOTS;
+    FS_STAT(m_probeCount++);
+    for (int i = stash; i < capacity; i++) {
+        if (table[i].occupied() and table[i].getDiskBlock() == block and table[i].getHash() == hash
+            and table[i].nameEquals(file.m_name)) {
+            return &table[i];
+        }
+    }
+    return nullptr;
+}
+
+/*
+This is a helper function that makes an empty slot for a file in one of its name's two
+buckets and returns its index. Only an empty slot is free: a deleted entry stays where
+getFile and updateDiskBlock find it, and moves like a live one. When both buckets are full,
+a breadth first search over the buckets the stored entries could move to looks for the
+shortest displacement path to an empty slot (at most CUCKOOPATH buckets), and the entries on
+the path are shifted to their other bucket one by one. The files of one name share their
+buckets, so they can't make room for each other. A file that finds no path goes to the
+stash, which marks the table as flooded so insert rehashes it with a new seed. Once the
+stash is full too there is no slot: -1 is returned and the caller rebuilds the table with
+cuckooGrow.
+*/
+int FileSys::cuckooPlace(unsigned int hash, Slot* table, int capacity) {
+    struct PathNode{
+        int bucket;
+        int parent;     // node of the bucket the file comes from, -1 for the file's own buckets
+        int slot;       // slot of that file in the parent's bucket
+    };
+    int first, second;
+    cuckooBuckets(hash, capacity, first, second);
+    vector<PathNode> nodes;
+    nodes.push_back({first, -1, -1});
+    nodes.push_back({second, -1, -1});
+    int freeIndex = -1;
+    int node = 0;
+    for (; node < (int)nodes.size() and freeIndex == -1; node++) {
+        Slot* bucket = table + nodes[node].bucket * CUCKOOSLOTS;
+        for (int i = 0; i < CUCKOOSLOTS and freeIndex == -1; i++) {
+            if (!bucket[i].occupied()) {
+                freeIndex = nodes[node].bucket * CUCKOOSLOTS + i;
+            }
+        }
+        for (int i = 0; i < CUCKOOSLOTS and freeIndex == -1 and nodes.size() < (size_t)CUCKOOPATH; i++) {
+            int a, b;
+            cuckooBuckets(bucket[i].getHash(), capacity, a, b);
+            nodes.push_back({a == nodes[node].bucket ? b : a, node, i});
+        }
+    }
+    if (freeIndex == -1) {
+        // no path, the stash
+        m_floodDetected = true;
+        int stash = (capacity - CUCKOOSTASH) / CUCKOOSLOTS * CUCKOOSLOTS;
+        for (int i = stash; i < capacity and freeIndex == -1; i++) {
+            if (!table[i].occupied()) {
+                freeIndex = i;
+            }
+        }
+        node = 0;
+    }else {
+        node--; // the node whose bucket has the free slot
+    }
+    if (freeIndex == -1) {
+        return -1;
+    }
+    // shift the entries along the path, the last one first
+    while (nodes[node].parent != -1 and freeIndex >= nodes[node].bucket * CUCKOOSLOTS
+           and freeIndex < (nodes[node].bucket + 1) * CUCKOOSLOTS) {
+        int from = nodes[nodes[node].parent].bucket * CUCKOOSLOTS + nodes[node].slot;
+        preserve(table, freeIndex);
+        preserve(table, from);
+        table[freeIndex] = table[from];   // the long name moves with the slot
+        table[from].m_word = 0;
+        freeIndex = from;
+        node = nodes[node].parent;
+    }
+    return freeIndex;
+}
+
+/*
+This is a helper function that rebuilds the current CUCKOO table once a file found neither a
+displacement path nor a free slot in the stash. The entries move into a table of twice the
+capacity (at most MAXPRIME) under a new SipHash key, which also breaks up a flood of
+colliding names. The live files are placed first, then the deleted entries, the way insert
+places a file; the long names move with their slots. A new table that runs out of room is
+thrown away for another try with a new key. The deleted entries of a name can take the room
+its live files need under every key, so the last try leaves them out, as a rehash would.
+After CUCKOOREBUILDS tries the table stays as it was and false is returned.
+*/
+bool FileSys::cuckooGrow() {
+    // every bucket moves
+    detachSnapshots();
+    if (m_cache != nullptr) {
+        m_cache->clear();
+    }
+    Slot* oldTable = m_currentTable;
+    int oldCap = m_currentCap;
+    bool oldSeeded = m_currSeeded;
+    unsigned long long oldSeed[2] = {m_currSeed[0], m_currSeed[1]};
+    int capacity = findNextPrime(2 * oldCap);
+    for (int attempt = 0; attempt < CUCKOOREBUILDS; attempt++) {
+        bool keepDeleted = attempt < CUCKOOREBUILDS - 1;
+        // tableHash hashes with the key of the current table, so the new one takes its place
+        m_currentCap = capacity;
+        m_currentTable = allocTable(m_currentCap);
+        m_currSeeded = true;
+        newSeed(m_currSeed);
+        bool placed = true;
+        int size = 0;
+        int deleted = 0;
+        for (int pass = 0; pass < 2 and placed; pass++) {
+            bool live = (pass == 0); // the live files first
+            for (int i = 0; i < oldCap and placed; i++) {
+                if (!oldTable[i].occupied() or oldTable[i].getUsed() != live or (!live and !keepDeleted)) {
+                    continue;
+                }
+                unsigned int hash = tableHash(oldTable[i].getName(), m_currentTable);
+                int index = cuckooPlace(hash, m_currentTable, m_currentCap);
+                placed = index >= 0;
+                if (placed) {
+                    m_currentTable[index] = oldTable[i];
+                    m_currentTable[index].m_word = (oldTable[i].m_word & 0xffffffffULL) | ((unsigned long long)hash << SLOTHASHSHIFT);
+                    size++;
+                    deleted += live ? 0 : 1;
+                }
+            }
+        }
+        if (!placed) {
+            // the long names still belong to the old table
+            memset(m_currentTable, 0, m_currentCap * sizeof(Slot));
+            freeTable(m_currentTable, m_currentCap);
+            continue;
+        }
+
+        for (int i = 0; i < oldCap; i++) {
+            if (oldTable[i].occupied() and !oldTable[i].getUsed() and !keepDeleted) {
+                freeName(oldTable[i]);
+            }
+            oldTable[i].m_word = 0; // moved or left out
+        }
+        m_currentSize = size;
+        m_currNumDeleted = deleted;
+        freeTable(oldTable, oldCap);
+        if (m_currFilter != nullptr) {
+            freeFilter(m_currFilter);
+            m_currFilter = buildFilter(m_currentTable, m_currentCap);
+        }
+        // the tables after this one keep the seeded hash for the reason insert() gives,
+        // and the flood has had its reseed
+        m_newSeeded = true;
+        m_reseeded = true;
+        FS_STAT(m_stats.rehashCount++);
+        FS_STAT(m_stats.reseedCount++);
+        return true;
+    }
+    m_currentTable = oldTable;
+    m_currentCap = oldCap;
+    m_currSeeded = oldSeeded;
+    m_currSeed[0] = oldSeed[0];
+    m_currSeed[1] = oldSeed[1];
+    return false;
+}
+
+/*
+This is a helper function that returns true if no name has more than CUCKOONAMEMAX live
+files in the table, so that all of them fit in a CUCKOO table.
+*/
+bool FileSys::cuckooFits(const Slot* table, int capacity) const {
+    map<string, int> files;
+    for (int i = 0; i < capacity; i++) {
+        if (table[i].occupied() and table[i].getUsed() and ++files[table[i].getName()] > CUCKOONAMEMAX) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+This is a helper function that returns the hash value of a name in the given table.
+Every table remembers whether it uses the user hash function or SipHash and its seed,
+so the old table keeps its hash while the current one already has a new one.
+*/
+unsigned int FileSys::tableHash(const string & name, const Slot* table) const {
+    bool seeded = (table == m_oldTable and table != nullptr) ? m_oldSeeded : m_currSeeded;
+    if (!seeded) {
+        return m_hash(name);
+    }
+    const unsigned long long* seed = (table == m_oldTable) ? m_oldSeed : m_currSeed;
+    unsigned long long hash = sipHash(seed, name);
+    return (unsigned int)(hash ^ (hash >> 32));
+}
+
+void FileSys::newSeed(unsigned long long seed[2]) {
+    std::random_device device;
+    seed[0] = ((unsigned long long)device() << 32) | device();
+    seed[1] = ((unsigned long long)device() << 32) | device();
+}
+
+void FileSys::setTrace(TraceWriter* trace) {
+    MaintenanceGuard guard(m_maintenance);
+    m_trace = trace;
+}
+
+/*
+The index holds (name, block) of the live entries only. updateDiskBlock changes
+deleted entries alone, so only insert and remove have to keep it up to date.
+*/
+void FileSys::setOrderedIndex(bool enabled) {
+    MaintenanceGuard guard(m_maintenance);
+    if (!enabled) {
+        delete m_index;
+        m_index = nullptr;
+        return;
+    }
+    if (m_index != nullptr) {
+        return;
+    }
+    m_index = new OrderedIndex();
+    for (int i = 0; i < m_currentCap; i++) {
+        if (m_currentTable[i].occupied() and m_currentTable[i].getUsed()) {
+            m_index->insert(make_pair(m_currentTable[i].getName(), m_currentTable[i].getDiskBlock()));
+        }
+    }
+    if (m_oldTable != nullptr) {
+        for (int i = 0; i < m_oldCap; i++) {
+            if (m_oldTable[i].occupied() and m_oldTable[i].getUsed()) {
+                m_index->insert(make_pair(m_oldTable[i].getName(), m_oldTable[i].getDiskBlock()));
+            }
+        }
+    }
+}
+
+void FileSys::setBackgroundMaintenance(bool enabled, int budgetMicros, int intervalMicros) {
+    if (enabled) {
+        if (m_maintenance != nullptr) {
+            MaintenanceGuard guard(m_maintenance);
+            m_maintenance->budgetMicros = budgetMicros;
+            m_maintenance->intervalMicros = intervalMicros;
+            return;
+        }
+        m_maintenance = new MaintenanceThread();
+        m_maintenance->stop = false;
+        m_maintenance->budgetMicros = budgetMicros;
+        m_maintenance->intervalMicros = intervalMicros;
+        m_maintenance->thread = std::thread(&FileSys::maintain, this);
+        return;
+    }
+    if (m_maintenance == nullptr) {
+        return;
+    }
+    {
+        MaintenanceGuard guard(m_maintenance);
+        m_maintenance->stop = true;
+    }
+    m_maintenance->wake.notify_all();
+    m_maintenance->thread.join();
+    delete m_maintenance;
+    m_maintenance = nullptr;
+    // without the thread a rehash is done in one go again
+    transfer(-1);
+}
+
+/*
+Every intervalMicros the thread takes the lock the table operations take and works
+for about budgetMicros: it starts a rehash when the load factor reached GROWLOAD (as
+long as the table can still grow) or the deleted ratio reached PURGERATIO, in which
+case the deleted entries are cleared in place when purgeFits allows it, checks the
+window of the adaptive policy, and moves
+entries of the rehash in progress until the budget is used up. The operations keep
+going between the runs; the ones that start a rehash themselves only swap the tables.
+*/
+void FileSys::maintain() {
+    std::unique_lock<std::recursive_mutex> lock(m_maintenance->lock);
+    while (!m_maintenance->stop) {
+        m_maintenance->wake.wait_for(lock, std::chrono::microseconds(m_maintenance->intervalMicros));
+        if (m_maintenance->stop) {
+            break;
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool worked = false;
+        if (m_oldTable == nullptr and m_frozen == nullptr and m_currentSize > 0) {
+            bool grow = wantsGrow();
+            if (!grow and deletedRatio() >= PURGERATIO and purgeFits()) {
+                purgeDeleted();
+                worked = true;
+            }else if (grow or deletedRatio() >= PURGERATIO) {
+                m_forceRehash = true;
+                rehash();
+                worked = true;
+            }
+        }
+        // a window filled by lookups alone has no insert or remove to check it
+        if (m_adaptive and m_oldTable == nullptr and m_frozen == nullptr and checkAdaptive()) {
+            worked = true;
+        }
+        if (m_oldTable != nullptr) {
+            long long spent = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            transfer(max(0LL, m_maintenance->budgetMicros * 1000LL - spent));
+            worked = true;
+        }
+        FS_STAT(if (worked) {
+            m_stats.maintenanceRuns++;
+            m_stats.maintenanceNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        });
+    }
+}
+
+void FileSys::setFrontCache(int entries) {
+    MaintenanceGuard guard(m_maintenance);
+    delete m_cache;
+    m_cache = nullptr;
+    if (entries > 0) {
+        m_cache = new FrontCache(entries);
+    }
+}
+
+/*
+The filters hold every occupied bucket, deleted entries included, since searchForFile
+finds those too. remove leaves them alone; a pair only leaves a filter when insert
+overwrites its deleted entry, when updateDiskBlock changes its block, or when a rehash
+drops the deleted entries and the filter is rebuilt with the new table.
+*/
+void FileSys::setNegativeFilter(bool enabled) {
+    MaintenanceGuard guard(m_maintenance);
+    freeFilter(m_currFilter);
+    freeFilter(m_oldFilter);
+    if (enabled) {
+        m_currFilter = buildFilter(m_currentTable, m_currentCap);
+        if (m_oldTable != nullptr) {
+            m_oldFilter = buildFilter(m_oldTable, m_oldCap);
+        }
+    }
+}
+
+CountingBloomFilter* FileSys::filterOf(const Slot* table) const {
+    return (table == m_oldTable and table != nullptr) ? m_oldFilter : m_currFilter;
+}
+
+CountingBloomFilter* FileSys::buildFilter(const Slot* table, int capacity) {
+    CountingBloomFilter* filter = new CountingBloomFilter(capacity);
+    for (int i = 0; i < capacity; i++) {
+        if (table[i].occupied()) {
+            filter->add(table[i].getName(), table[i].getDiskBlock());
+        }
+    }
+    m_footprint += filter->bytes();
+    FS_STAT(m_stats.bytesAllocated += filter->bytes());
+    return filter;
+}
+
+void FileSys::freeFilter(CountingBloomFilter*& filter) {
+    if (filter != nullptr) {
+        m_footprint -= filter->bytes();
+        delete filter;
+        filter = nullptr;
+    }
+}
+
+/*
+The allocator counts the live files of every block. updateDiskBlock only changes
+the blocks of deleted entries and a rehash moves the live files as they are, so
+insert and remove are the only operations that change it.
+*/
+void FileSys::setBlockAllocator(bool enabled) {
+    MaintenanceGuard guard(m_maintenance);
+    if (!enabled) {
+        if (m_blocks != nullptr) {
+            m_footprint -= m_blocks->bytes();
+            delete m_blocks;
+            m_blocks = nullptr;
+        }
+        return;
+    }
+    if (m_blocks != nullptr) {
+        return;
+    }
+    m_blocks = new BlockAllocator();
+    m_footprint += m_blocks->bytes();
+    for (int i = 0; i < m_currentCap; i++) {
+        if (m_currentTable[i].occupied() and m_currentTable[i].getUsed()) {
+            m_blocks->acquire(m_currentTable[i].getDiskBlock());
+        }
+    }
+    if (m_oldTable != nullptr) {
+        for (int i = 0; i < m_oldCap; i++) {
+            if (m_oldTable[i].occupied() and m_oldTable[i].getUsed()) {
+                m_blocks->acquire(m_oldTable[i].getDiskBlock());
+            }
+        }
+    }
+}
+
+int FileSys::freeBlock(int from) const {
+    MaintenanceGuard guard(m_maintenance);
+    if (m_blocks == nullptr) {
+        return -1;
+    }
+    return m_blocks->findFree(from);
+}
+
+int FileSys::freeRun(int count) const {
+    MaintenanceGuard guard(m_maintenance);
+    if (m_blocks == nullptr) {
+        return -1;
+    }
+    return m_blocks->findRun(count);
+}
+
+/*
+The live files of both tables go into the frozen table; the deleted entries are
+dropped, so getFile stops finding them. The hash table is replaced by an empty
+one of MINPRIME buckets, which keeps every other member function working on
+it, and the front cache and the filter of the old table are emptied with it.
+The ordered index and the block allocator hold the live files, which stay the
+same, so they are kept.
+*/
+void FileSys::freeze() {
+    MaintenanceGuard guard(m_maintenance);
+    if (m_frozen != nullptr) {
+        return;
+    }
+    detachSnapshots();
+    vector<pair<string, int> > files;
+    for (int i = 0; i < m_currentCap; i++) {
+        if (m_currentTable[i].occupied() and m_currentTable[i].getUsed()) {
+            files.push_back(make_pair(m_currentTable[i].getName(), m_currentTable[i].getDiskBlock()));
+        }
+    }
+    if (m_oldTable != nullptr) {
+        for (int i = 0; i < m_oldCap; i++) {
+            if (m_oldTable[i].occupied() and m_oldTable[i].getUsed()) {
+                files.push_back(make_pair(m_oldTable[i].getName(), m_oldTable[i].getDiskBlock()));
+            }
+        }
+    }
+    m_frozen = new FrozenTable(files);
+    m_footprint += m_frozen->bytes();
+
+    if (m_cache != nullptr) {
+        m_cache->clear();
+    }
+    bool filtered = (m_currFilter != nullptr);
+    freeFilter(m_currFilter);
+    freeFilter(m_oldFilter);
+    freeTable(m_currentTable, m_currentCap);
+    freeTable(m_oldTable, m_oldCap);
+    m_currentCap = MINPRIME;
+    m_currentTable = allocTable(m_currentCap);
+    m_currentSize = 0;
+    m_currNumDeleted = 0;
+    m_oldCap = 0;
+    m_oldSize = 0;
+    m_oldNumDeleted = 0;
+    m_transferIndex = -1; // the old table went into the frozen one
+    if (filtered) {
+        m_currFilter = buildFilter(m_currentTable, m_currentCap);
+    }
+}
+
+Snapshot* FileSys::snapshot() {
+    MaintenanceGuard guard(m_maintenance);
+    if (m_frozen != nullptr) {
+        return nullptr;
+    }
+    transfer(-1); // a snapshot reads one table
+    Snapshot* snapshot = new Snapshot(this);
+    m_snapshots.push_back(snapshot);
+    return snapshot;
+}
+
+void FileSys::savePages(int index) {
+    for (size_t i = 0; i < m_snapshots.size(); i++) {
+        m_snapshots[i]->savePage(index / SNAPPAGE);
+    }
+}
+
+void FileSys::detachSnapshots() {
+    for (size_t i = 0; i < m_snapshots.size(); i++) {
+        m_snapshots[i]->detach();
+    }
+    m_snapshots.clear();
+}
+
+Snapshot::Snapshot(FileSys* filesys):
+m_filesys(filesys),
+m_table(filesys->m_currentTable),
+m_capacity(filesys->m_currentCap),
+m_probing(filesys->m_currProbing),
+m_seeded(filesys->m_currSeeded),
+m_hash(filesys->m_hash),
+m_size(filesys->m_currentSize - filesys->m_currNumDeleted),
+m_position(0),
+m_pages((filesys->m_currentCap + SNAPPAGE - 1) / SNAPPAGE, nullptr)
+{
+    m_seed[0] = filesys->m_currSeed[0];
+    m_seed[1] = filesys->m_currSeed[1];
+}
+
+Snapshot::~Snapshot() {
+    FileSys* filesys = m_filesys.load(memory_order_acquire);
+    if (filesys != nullptr) {
+        MaintenanceGuard guard(filesys->m_maintenance);
+        // the table may have let go of the snapshot while this waited for the lock
+        if (m_filesys.load(memory_order_relaxed) != nullptr) {
+            vector<Snapshot*> & snapshots = filesys->m_snapshots;
+            snapshots.erase(std::find(snapshots.begin(), snapshots.end(), this));
+        }
+    }
+    for (size_t i = 0; i < m_pages.size(); i++) {
+        delete[] m_pages[i];
+    }
+}
+
+const File Snapshot::getFile(string name, int block) const {
+    // a snapshot let go of in the meantime has all of its pages, the table isn't read then
+    FileSys* filesys = m_filesys.load(memory_order_acquire);
+    MaintenanceGuard guard(filesys != nullptr ? filesys->m_maintenance : nullptr);
+    if (block < DISKMIN or block > DISKMAX) {
+        return File();
+    }
+    int index = find(name, block);
+    if (index == -1) {
+        return File();
+    }
+    return File(name, block, (wordAt(index) & SLOTUSED) != 0);
+}
+
+bool Snapshot::next(File & file) {
+    FileSys* filesys = m_filesys.load(memory_order_acquire);
+    MaintenanceGuard guard(filesys != nullptr ? filesys->m_maintenance : nullptr);
+    while (m_position < m_capacity) {
+        int index = m_position++;
+        unsigned long long word = wordAt(index);
+        if ((word & SLOTOCCUPIED) and (word & SLOTUSED)) {
+            file = File(nameAt(index), DISKMIN + (int)(word & SLOTBLOCKMASK), true);
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t Snapshot::bytes() const {
+    size_t bytes = 0;
+    for (size_t i = 0; i < m_pages.size(); i++) {
+        if (m_pages[i] != nullptr) {
+            bytes += SNAPPAGE * sizeof(SnapSlot);
+            for (int j = 0; j < SNAPPAGE; j++) {
+                bytes += m_pages[i][j].name.size();
+            }
+        }
+    }
+    return bytes;
+}
+
+void Snapshot::savePage(int page) {
+    if (m_pages[page] != nullptr) {
+        return;
+    }
+    SnapSlot* slots = new SnapSlot[SNAPPAGE];
+    for (int i = 0; i < SNAPPAGE and page * SNAPPAGE + i < m_capacity; i++) {
+        const Slot & slot = m_table[page * SNAPPAGE + i];
+        slots[i].word = slot.m_word;
+        if (slot.occupied()) {
+            slots[i].name = slot.getName();
+        }
+    }
+    for (int i = m_capacity - page * SNAPPAGE; i < SNAPPAGE; i++) {
+        slots[i].word = 0; // past the end of the table
+    }
+    m_pages[page] = slots;
+}
+
+void Snapshot::detach() {
+    for (size_t page = 0; page < m_pages.size(); page++) {
+        savePage(page);
+    }
+    m_table = nullptr;
+    m_filesys.store(nullptr, memory_order_release);
+}
+
+unsigned long long Snapshot::wordAt(int index) const {
+    const SnapSlot* page = m_pages[index / SNAPPAGE];
+    return page != nullptr ? page[index % SNAPPAGE].word : m_table[index].m_word;
+}
+
+string Snapshot::nameAt(int index) const {
+    const SnapSlot* page = m_pages[index / SNAPPAGE];
+    return page != nullptr ? page[index % SNAPPAGE].name : m_table[index].getName();
+}
+
+/*
+The search of the table the snapshot was taken from, searchForFile or cuckooFind,
+over the pages as they were at the time.
+*/
+int Snapshot::find(const string & name, int block) const {
+    unsigned int hash;
+    if (m_seeded) {
+        unsigned long long seeded = sipHash(m_seed, name);
+        hash = (unsigned int)(seeded ^ (seeded >> 32));
+    }else {
+        hash = m_hash(name);
+    }
+    unsigned long long key = ((unsigned long long)hash << SLOTHASHSHIFT) | SLOTOCCUPIED | (unsigned long long)(block - DISKMIN);
+    unsigned long long keyMask = ~0ULL << SLOTHASHSHIFT | SLOTOCCUPIED | SLOTBLOCKMASK;
+
+    if (m_probing == CUCKOO) {
+        int first, second;
+        FileSys::cuckooBuckets(hash, m_capacity, first, second);
+        int buckets[2] = {first, second};
+        for (int b = 0; b < 2; b++) {
+            for (int i = buckets[b] * CUCKOOSLOTS; i < (buckets[b] + 1) * CUCKOOSLOTS; i++) {
+                if ((wordAt(i) & keyMask) == key and nameAt(i) == name) {
+                    return i;
+                }
+            }
+        }
+        int stash = (m_capacity - CUCKOOSTASH) / CUCKOOSLOTS * CUCKOOSLOTS;
+        for (int i = stash; i < m_capacity; i++) {
+            if ((wordAt(i) & keyMask) == key and nameAt(i) == name) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    int origIndex = hash % m_capacity;
+    int currIndex = origIndex;
+    int collisionAmt = 0;
+    while (wordAt(origIndex) & SLOTOCCUPIED) {
+        if ((wordAt(origIndex) & keyMask) == key and nameAt(origIndex) == name) {
+            return origIndex;
+        }
+        switch (m_probing) {
+            case LINEAR:
+                origIndex = (currIndex + collisionAmt) % m_capacity;
+                break;
+            case QUADRATIC:
+                origIndex = (currIndex + (collisionAmt * collisionAmt)) % m_capacity;
+                break;
+            default:
+                int stepSize = hash % (m_capacity - 1) + 1;
+                origIndex = (currIndex + (collisionAmt * stepSize)) % m_capacity;
+                break;
+        }
+        collisionAmt++;
+    }
+    return -1;
+}
+
+/*
+A free block can still be taken by a deleted entry of the same name, which makes
+the insert a duplicate until the next rehash. The search then moves on to the next
+free block; any other failure (a full table, no room in the allocator) is final.
+*/
+int FileSys::createFile(string name) {
+    MaintenanceGuard guard(m_maintenance);
+    if (m_blocks == nullptr) {
+        return -1;
+    }
+    int block = m_blocks->findFree();
+    while (block != -1) {
+        File file(name, block, true);
+        if (insert(file)) {
+            return block;
+        }
+        if (searchForFile(file, m_currentTable, m_currentCap, m_currProbing) == nullptr) {
+            return -1;
+        }
+        block = m_blocks->findFree(block + 1);
+    }
+    return -1;
+}
+
+FileCursor FileSys::scanPrefix(string prefix) const {
+    return FileCursor(this, prefix, "", true);
+}
+
+FileCursor FileSys::scanRange(string first, string last) const {
+    return FileCursor(this, first, last, false);
+}
+
+FileCursor::FileCursor(const FileSys* filesys, string first, string last, bool prefix):
+m_filesys(filesys),
+m_first(first),
+m_last(last),
+m_prefix(prefix),
+m_started(false)
+{}
+
+bool FileCursor::next(File & file) {
+    if (m_filesys == nullptr) {
+        return false;
+    }
+    MaintenanceGuard guard(m_filesys->m_maintenance);
+    const OrderedIndex* index = m_filesys->m_index;
+    if (index == nullptr) {
+        return false;
+    }
+    // the smallest key is (m_first, INT_MIN), every block of the first name included
+    OrderedIndex::const_iterator it = m_started ? index->upper_bound(m_position)
+                                                : index->lower_bound(make_pair(m_first, INT_MIN));
+    if (it == index->end()) {
+        return false;
+    }
+    if (m_prefix and it->first.compare(0, m_first.size(), m_first) != 0) {
+        return false;
+    }
+    if (!m_prefix and !m_last.empty() and it->first >= m_last) {
+        return false;
+    }
+    m_position = *it;
+    m_started = true;
+    file = File(it->first, it->second, true);
+    return true;
+}
+
+bool FileSys::isPrime(int number) const {
     bool result = true;
     for (int i = 2; i <= number / 2; i++) {
         if (number % i == 0) {
@@ -417,7 +2162,7 @@ bool FileSys::isPrime(int number){
     return result;
 }
 
-int FileSys::findNextPrime(int current){
+int FileSys::findNextPrime(int current) const {
     //we always stay within the range [MINPRIME-MAXPRIME]
     //the smallest prime starts at MINPRIME
     if (current < MINPRIME) current = MINPRIME-1;
@@ -1,20 +1,60 @@
 // CMSC 341 - Fall 2024 - Project 4
 #ifndef FILESYS_H
 #define FILESYS_H
+#include <atomic>
+#include <deque>
 #include <iostream>
+#include <set>
+#include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 #include "math.h"
 using namespace std;
+
+// FILESYS_STATS compiles the instrumentation counters into the hash table.
+// Without it every FS_STAT(...) statement disappears and getStats() reports zeros.
+#ifdef FILESYS_STATS
+#define FS_STAT(statement) statement
+#else
+#define FS_STAT(statement)
+#endif
 const int DISKMIN = 100000;
 const int DISKMAX = 999999;
 const int MINPRIME = 101;   // Min size for hash table
 const int MAXPRIME = 99991; // Max size for hash table
 typedef unsigned int (*hash_fn)(string); // declaration of hash function
-enum prob_t {QUADRATIC, DOUBLEHASH, LINEAR}; // types of collision handling policy
+enum prob_t {QUADRATIC, DOUBLEHASH, LINEAR, CUCKOO}; // types of collision handling policy
 #define DEFPOLCY QUADRATIC
+enum stat_op_t {STATINSERT, STATREMOVE, STATFIND, STATUPDATE}; // operation types tracked by the statistics
+const int NUMSTATOPS = 4;
+const int PROBEBUCKETS = 10; // probe length histogram buckets: <=1, <=2, <=4, ..., <=256, more
+const int FLOODPROBES = 64;  // probes past entries of other names that count as a flooded chain
+const int CUCKOOSLOTS = 4;   // slots per bucket of a CUCKOO table
+const int CUCKOOSTASH = 8;   // slots at the end of a CUCKOO table for files no bucket has room for
+const int CUCKOOPATH = 256;  // buckets a CUCKOO insert searches for a displacement path
+const int CUCKOOREBUILDS = 4; // rebuilds of a CUCKOO table with a new seed before an insert gives up
+const int CUCKOONAMEMAX = CUCKOOSLOTS; // live files a name may have in a CUCKOO table, one bucket's worth
+const float GROWLOAD = 0.4;  // load factor at which a table is grown ahead of the 0.5 threshold by
+                             // FileSysManager::maintain() and the background maintenance
+const float PURGERATIO = 0.4; // deleted ratio at which the deleted entries are dropped in the background
+const float OCCUPIEDMAX = 0.5; // occupied buckets, deleted entries included, at which the table is rebuilt
+const int TRANSFERSTEP = 256; // buckets the background transfer moves between two looks at its time budget
+const int ADAPTWINDOW = 4096; // sampled operations between two checks of the adaptive policy (at least the capacity)
+const float ADAPTPROBES = 1.5; // average probes per operation of a window that make the adaptive policy look around
+const float ADAPTGAIN = 0.8;  // another policy must cost less than this share of the current one to move to it
+const int ADAPTLINECOST = 4;  // cost of a probe into a cache line the search hasn't touched yet, a probe is 1
 class Grader;
 class Tester;
 class FileSys;
+class TraceWriter;
+class TableAllocator;
+class FrontCache;
+class CountingBloomFilter;
+class BlockAllocator;
+class FrozenTable;
+struct MaintenanceThread;
+typedef set<pair<string, int> > OrderedIndex; // (name, disk block) of the live files in name order
 class File{
     public:
     friend class Grader;
@@ -70,11 +110,191 @@ class File{
     bool m_used;
 };
 
+// Bit layout of the packed word of a Slot. The disk block is stored as its
+// offset from DISKMIN, [0-899999] fits in 20 bits. The upper half of the word
+// caches the hash value of the name in the table the slot belongs to.
+const int SLOTBLOCKBITS = 20;
+const unsigned long long SLOTBLOCKMASK = (1ULL << SLOTBLOCKBITS) - 1;
+const unsigned long long SLOTOCCUPIED = 1ULL << 20; // the bucket holds an entry, live or deleted
+const unsigned long long SLOTUSED = 1ULL << 21;     // the entry is live (File::m_used)
+const unsigned long long SLOTLONGNAME = 1ULL << 22; // the name is on the heap instead of inline
+const int SLOTLENGTHSHIFT = 23;                     // 5 bits of inline name length
+const unsigned long long SLOTPENDING = 1ULL << 28;  // a live entry an in-place purge hasn't put back yet
+const int SLOTHASHSHIFT = 32;
+const int SLOTINLINE = 16;  // names up to this many bytes are stored in the slot itself
+
+// One bucket of a FileSys table, 24 bytes. The table is an array of slots
+// rather than of pointers to File objects, so a typical entry costs no
+// allocation at all: the disk block, the deleted flag and a hash tag share
+// one 64 bit word and a name of up to SLOTINLINE bytes is stored inline.
+// Longer names live in a heap buffer owned by the FileSys object. A slot with
+// the word set to zero is an empty bucket (a nullptr in the pointer table).
+class Slot{
+    public:
+    friend class Grader;
+    friend class Tester;
+    friend class FileSys;
+    friend class Snapshot;
+    bool occupied() const {return (m_word & SLOTOCCUPIED) != 0;}
+    bool getUsed() const {return (m_word & SLOTUSED) != 0;}
+    int getDiskBlock() const {return DISKMIN + (int)(m_word & SLOTBLOCKMASK);}
+    unsigned int getHash() const {return (unsigned int)(m_word >> SLOTHASHSHIFT);}
+    bool isLongName() const {return (m_word & SLOTLONGNAME) != 0;}
+    size_t nameLength() const {
+        return isLongName() ? m_heap.length : (size_t)((m_word >> SLOTLENGTHSHIFT) & 0x1f);
+    }
+    const char* nameData() const {return isLongName() ? m_heap.data : m_inline;}
+    string getName() const {return string(nameData(), nameLength());}
+    bool nameEquals(const string & name) const {
+        return name.size() == nameLength() and name.compare(0, name.size(), nameData(), name.size()) == 0;
+    }
+    // returns a copy of the entry as a File object
+    File toFile() const {return File(getName(), getDiskBlock(), getUsed());}
+    // the following function is a friend function
+    friend ostream& operator<<(ostream& sout, const Slot & slot){
+        if (slot.occupied() and slot.nameLength() > 0)
+            sout << slot.getName() << " (" << slot.getDiskBlock() << ", "<< slot.getUsed() <<  ")";
+        else
+            sout << "";
+        return sout;
+    }
+    private:
+    struct HeapName{
+        char* data;
+        unsigned long long length;
+    };
+    // block offset, flags, inline name length and the hash tag, see the layout above
+    unsigned long long m_word;
+    union{
+        char m_inline[SLOTINLINE];  // short names, not null terminated
+        HeapName m_heap;            // long names
+    };
+    void setDiskBlock(int block) {m_word = (m_word & ~SLOTBLOCKMASK) | (unsigned long long)(block - DISKMIN);}
+    void setUsed(bool used) {m_word = used ? (m_word | SLOTUSED) : (m_word & ~SLOTUSED);}
+};
+static_assert(sizeof(Slot) == 24, "a Slot must stay 24 bytes");
+
+// Counters collected by a FileSys object when it is compiled with FILESYS_STATS.
+// A probe is one inspected bucket, the bucket that ends a search included.
+struct FileSysStats{
+    unsigned long long probeHistogram[NUMSTATOPS][PROBEBUCKETS]; // operations per probe length bucket
+    unsigned long long probeTotal[NUMSTATOPS];  // sum of the probe lengths
+    unsigned long long hits[NUMSTATOPS];        // operations that found (or inserted) the file
+    unsigned long long misses[NUMSTATOPS];      // operations that did not
+    unsigned long long tombstonesTraversed;     // deleted buckets skipped while probing
+    unsigned long long rehashCount;             // number of rehash operations
+    unsigned long long rehashNanos;             // total time spent in rehash
+    unsigned long long purgeCount;              // purges that cleared the deleted entries in place instead of a rehash
+    unsigned long long entriesMoved;            // live entries transferred by rehash
+    unsigned long long reseedCount;             // rehashes done to change the hash seed after a flooded chain
+    unsigned long long bytesInUse;              // heap bytes held by the tables and their long names (footprint())
+    unsigned long long bytesAllocated;          // heap bytes allocated since construction
+    unsigned long long cacheHits;               // getFile calls answered by the front cache
+    unsigned long long cacheMisses;             // getFile calls the front cache could not answer
+    unsigned long long cacheEvictions;          // files the front cache dropped to make room
+    unsigned long long filterNegatives;         // searches the negative lookup filter ended without probing
+    unsigned long long filterFalsePositives;    // searches the filter let through that found nothing
+    unsigned long long maintenanceRuns;         // runs of the background maintenance that found work to do
+    unsigned long long maintenanceNanos;        // time the background maintenance spent working
+    unsigned long long policyChanges;           // rehashes the adaptive policy did to change the policy
+};
+
+// Metric families of the Prometheus text format collected from one or more tables.
+// Every family gets its HELP and TYPE lines once, followed by the samples of all
+// the tables it was collected from, in the order the families were first seen.
+class StatFamilies{
+    public:
+    // returns the stream the samples of the family are written to, the family is
+    // added the first time its name is seen
+    ostream& family(string name, string help, string type);
+    void write(ostream& out) const;
+    private:
+    deque<string> m_names;
+    deque<string> m_headers;         // the HELP and TYPE lines
+    deque<ostringstream> m_samples;  // a deque, so the stream family() returned stays put
+};
+
+// Lazy iterator over the files of a FileSys object's ordered index whose names
+// fall in a prefix or a range. Every next() looks up the file following the
+// last one returned, so the files are produced one at a time and a cursor stays
+// valid while files are inserted and removed; it sees the index as it is at
+// each call. A cursor must not outlive its FileSys object.
+class FileCursor{
+    public:
+    FileCursor(const FileSys* filesys = nullptr, string first = "", string last = "", bool prefix = false);
+    // copies the next file into file, returns false when there are no more files
+    bool next(File & file);
+    private:
+    const FileSys* m_filesys;    // the index is looked up at every call, under the table's lock
+    string m_first;              // first name of the range, or the prefix
+    string m_last;               // end of the range (exclusive), empty for no end
+    bool   m_prefix;             // true if the names must start with m_first
+    bool   m_started;            // false until the first file is returned
+    pair<string, int> m_position; // last file returned
+};
+
+const int SNAPPAGE = 64; // slots a snapshot copies at once, when a write reaches one it still reads from the table
+
+// One bucket of a page a snapshot has copied: the word of the slot and its name.
+struct SnapSlot{
+    unsigned long long word;
+    string name;
+};
+
+// Point-in-time view of the files of a FileSys object, from FileSys::snapshot().
+//
+// The snapshot reads the live table, so creating one copies nothing. Before a write
+// changes a bucket, the FileSys object copies the page of SNAPPAGE buckets around it
+// into every snapshot that still reads that page from the table (copy-on-write), so
+// a snapshot costs memory only for the pages written since it was taken. A rehash,
+// a purge, freeze() or the destruction of the FileSys object copy the pages left,
+// after which the snapshot no longer depends on the table. Deleting the snapshot
+// releases it. With the background maintenance on, a snapshot may be read from
+// another thread while the table is written; every lookup takes the table's lock
+// for its duration only.
+class Snapshot{
+    public:
+    friend class FileSys;
+    friend class Tester;
+    ~Snapshot();
+    // the file as getFile returned it when the snapshot was taken
+    const File getFile(string name, int block) const;
+    // live files when the snapshot was taken
+    int size() const {return m_size;}
+    // copies the next live file into file, returns false at the end; rewind() starts over
+    bool next(File & file);
+    void rewind() {m_position = 0;}
+    // bytes of the pages copied so far
+    size_t bytes() const;
+    private:
+    Snapshot(FileSys* filesys);
+    atomic<FileSys*> m_filesys; // nullptr once every page is copied, read by the readers without the lock
+    Slot*      m_table;     // the table the pages not copied yet are read from
+    int        m_capacity;
+    prob_t     m_probing;
+    bool       m_seeded;
+    unsigned long long m_seed[2];
+    hash_fn    m_hash;
+    int        m_size;
+    int        m_position;  // next bucket of next()
+    vector<SnapSlot*> m_pages; // the copied pages, nullptr while a page is read from the table
+
+    void savePage(int page);
+    void detach();
+    unsigned long long wordAt(int index) const;
+    string nameAt(int index) const;
+    int find(const string & name, int block) const; // bucket of the pair, -1 if it isn't there
+};
+
 class FileSys{
     public:
     friend class Grader;
     friend class Tester;
-    FileSys(int size, hash_fn hash, prob_t probing);
+    friend class Snapshot;
+    friend class FileCursor;
+    // the tables and long names come from the allocator, or from new and delete if it is nullptr;
+    // an allocator shared by several FileSys objects must outlive all of them
+    FileSys(int size, hash_fn hash, prob_t probing, TableAllocator* allocator = nullptr);
     ~FileSys();
     // Returns Load factor of the new table
     float lambda() const;
@@ -86,43 +306,194 @@ class FileSys{
     bool remove(File file);
     // find can happen in either table
     const File getFile(string name, int block) const;
+    // returns the disk blocks of every live file with the name, in ascending order;
+    // the files of a name share one probe chain (two buckets and the stash under CUCKOO),
+    // so only that chain is walked; a frozen table binary searches its files sorted by name
+    vector<int> findAll(string name) const;
     // update the information
     bool updateDiskBlock(File file, int block);
+    // takes effect with the next rehash; a table where a name has more than CUCKOONAMEMAX
+    // live files keeps its policy instead of switching to CUCKOO
     void changeProbPolicy(prob_t policy);
+    // The adaptive policy samples the probe lengths of insert and getFile; once they grow
+    // long, the table is rehashed to the policy expected to probe the least with its files.
+    // The window is checked by insert, remove, updateDiskBlock and the maintenance thread
+    void setAdaptivePolicy(bool enabled);
+    bool isAdaptivePolicy() const {return m_adaptive;}
+    // returns the policy the live files would be probed best with, out of LINEAR, QUADRATIC
+    // and DOUBLEHASH; that is the current one unless another costs less than ADAPTGAIN of it
+    prob_t suggestPolicy() const;
+    // rehashes to the suggested policy right away, returns false if it is the current one
+    bool adaptPolicy();
+    // switches between the user hash function and SipHash keyed with a random
+    // seed per table; a table with entries is rehashed right away. A table that
+    // reseeded after a flooded probe chain keeps SipHash until this is called with false
+    void setSeededHash(bool seeded);
+    bool isSeededHash() const {return m_currSeeded;}
+    // Returns the bytes held by the tables and the names too long to be stored inline
+    size_t footprint() const;
+    // Returns the peak of additional bytes a rehash would allocate right now
+    size_t rehashBytes() const;
+    // rehashes now as if the load factor had passed 0.5, unless the allocator has no room for it
+    bool rehashNow();
+    // returns true if the load factor reached GROWLOAD and a rehash would make the table bigger,
+    // which it can't once the capacity is at MAXPRIME
+    bool wantsGrow() const;
     void dump() const;
+    // returns a copy of the instrumentation counters
+    FileSysStats getStats() const;
+    void resetStats();
+    // writes the counters in the Prometheus text exposition format,
+    // labels (e.g. table="t1") are added to every sample
+    void writeStats(ostream& out, string labels = "") const;
+    // adds the samples of writeStats() to families, for an output shared with other tables
+    void collectStats(StatFamilies& families, string labels = "") const;
+    // writes the counters to a file in the Prometheus text format
+    bool exportStats(string filename) const;
+    // records every following insert, remove, getFile and updateDiskBlock call
+    // to the trace, nullptr stops the recording (the caller owns the writer)
+    void setTrace(TraceWriter* trace);
+    // keeps an ordered index of the live files by name next to the table, which
+    // answers prefix and range queries without scanning the table; enabling it
+    // builds it from the files in the table, disabling it frees it
+    void setOrderedIndex(bool enabled);
+    bool hasOrderedIndex() const {return m_index != nullptr;}
+    // returns a cursor over the live files whose names start with prefix
+    // (a directory listing for a prefix like "/a/b/"), in name and block order
+    FileCursor scanPrefix(string prefix) const;
+    // returns a cursor over the live files with first <= name < last,
+    // an empty last means no upper end
+    FileCursor scanRange(string first, string last) const;
+    // puts a front cache of about the given number of entries in front of getFile,
+    // for the few files that receive most of the lookups; 0 removes it
+    void setFrontCache(int entries);
+    bool hasFrontCache() const {return m_cache != nullptr;}
+    // keeps a counting Bloom filter of the (name, block) pairs of every table, which
+    // answers most searches for missing files without probing; false removes it
+    void setNegativeFilter(bool enabled);
+    bool hasNegativeFilter() const {return m_currFilter != nullptr;}
+    // keeps a map of the disk blocks held by live files, which insert and remove keep up
+    // to date, so free blocks are found without trying them; false removes it
+    void setBlockAllocator(bool enabled);
+    bool hasBlockAllocator() const {return m_blocks != nullptr;}
+    // returns the lowest block >= from that no live file holds, -1 if there's none
+    // or the block allocator is off
+    int freeBlock(int from = DISKMIN) const;
+    // returns the first block of count consecutive free blocks, -1 if there's none
+    int freeRun(int count) const;
+    // inserts a file with the name at the lowest free block it can take and returns
+    // the block, -1 if the insert fails or the block allocator is off
+    int createFile(string name);
+    // converts the live files into a read-only table built on a minimal perfect hash,
+    // for file sets that are published once and then only read: getFile looks at one
+    // position, and insert, remove and updateDiskBlock are refused from then on
+    void freeze();
+    // returns a point-in-time view of the files, delete it to release it; a rehash in
+    // progress is finished first. Returns nullptr for a frozen table, it never changes.
+    Snapshot* snapshot();
+    int numSnapshots() const {return m_snapshots.size();}
+    bool isFrozen() const {return m_frozen != nullptr;}
+    // starts a thread that does the rehash work in the background: it transfers the entries
+    // of a rehash that insert or remove started, grows the table at GROWLOAD and drops the
+    // deleted entries at PURGERATIO, working at most budgetMicros every intervalMicros.
+    // The table operations (insert, remove, getFile, findAll, updateDiskBlock) may then be
+    // called from several threads; the other member functions wait for the thread's run
+    // but must not run alongside the table operations of other threads.
+    // false stops the thread and finishes its work in the calling thread
+    void setBackgroundMaintenance(bool enabled, int budgetMicros = 200, int intervalMicros = 1000);
+    bool hasBackgroundMaintenance() const {return m_maintenance != nullptr;}
     private:
     hash_fn    m_hash;          // hash function
     prob_t     m_newPolicy;     // stores the change of policy request
+    bool       m_newSeeded;     // stores the seeded hash request for the next table
 
-    File**     m_currentTable;  // hash table
+    Slot*      m_currentTable;  // hash table
     int        m_currentCap;    // hash table size (capacity)
     int        m_currentSize;   // current number of entries
                                 // m_currentSize includes deleted entries 
     int        m_currNumDeleted;// number of deleted entries
     prob_t     m_currProbing;   // collision handling policy
+    bool       m_currSeeded;    // true if the table uses SipHash instead of m_hash
+    unsigned long long m_currSeed[2]; // SipHash key of the table
 
-    File**     m_oldTable;      // hash table
+    Slot*      m_oldTable;      // hash table
     int        m_oldCap;        // hash table size (capacity)
     int        m_oldSize;       // current number of entries
                                 // m_oldSize includes deleted entries
     int        m_oldNumDeleted; // number of deleted entries
     prob_t     m_oldProbing;    // collision handling policy
+    bool       m_oldSeeded;     // true if the table uses SipHash instead of m_hash
+    unsigned long long m_oldSeed[2]; // SipHash key of the table
 
     int        m_transferIndex; // this can be used as a temporary place holder
                                 // during incremental transfer to scanning the table
+    bool       m_moving;        // insert is being called by the transfer
+
+    bool       m_adaptive;      // the policy follows the sampled probe lengths
+    mutable int m_lastProbes;   // buckets inspected by the last chain search
+    mutable unsigned long long m_adaptOps;    // operations sampled since the last check
+    mutable unsigned long long m_adaptProbes; // their probes
+
+    mutable FileSysStats m_stats;   // instrumentation counters, only updated with FILESYS_STATS
+    mutable int m_probeCount;       // probes done by the operation in progress
+    TraceWriter* m_trace;           // operation trace recorder, nullptr if not recording
+    OrderedIndex* m_index;          // ordered index of the live files, nullptr if disabled
+    FrontCache* m_cache;            // front cache of getFile, nullptr if disabled
+    CountingBloomFilter* m_currFilter; // negative lookup filter of the current table, nullptr if disabled
+    CountingBloomFilter* m_oldFilter;  // negative lookup filter of the old table
+    BlockAllocator* m_blocks;       // disk blocks held by the live files, nullptr if disabled
+    FrozenTable* m_frozen;          // the files after freeze(), nullptr until then
+    vector<Snapshot*> m_snapshots;  // snapshots that still read pages from the current table
+    MaintenanceThread* m_maintenance; // background maintenance thread, nullptr if disabled
+    mutable bool m_floodDetected;   // a probe passed more than FLOODPROBES entries of other names
+    bool       m_forceRehash;       // rehash at the next check even below the thresholds
+    bool       m_reseeded;          // the last rehash changed the seed because of a flooded chain
+    TableAllocator* m_allocator;    // allocator of the tables and long names, nullptr for new and delete
+    size_t     m_footprint;         // bytes held by the tables and the long names
 
     //private helper functions
-    bool isPrime(int number);
-    int findNextPrime(int current);
+    bool isPrime(int number) const;
+    int findNextPrime(int current) const;
 
     /******************************************
     * Private function declarations go here! *
     ******************************************/
-    void rehash(File **&table);
-    const File* searchForFile(const File & file, File** table, int capacity, prob_t probing) const; // helper function for getFile
-    bool updateFile(const File & file, File** table, int capacity, prob_t probing, int block); // helper function for updateDiskBlock
-    bool removeFile(const File & file, File** table, int capacity, prob_t probing); // helper function for remove
-    bool insertFile(const File & file, File** table, int capacity, prob_t probing); // helper function for insert
+    void rehash();
+    bool transfer(long long budgetNanos); // moves entries of the old table, -1 for all of them
+    bool purgeFits() const;  // the deleted entries can be cleared without a new table
+    void purgeDeleted();     // clears them in the current table
+    void maintain(); // the body of the background maintenance thread
+    void sampleProbes() const; // adds the last search to the adaptive policy's window
+    bool checkAdaptive();      // adapts the policy at the end of a window of long probes, true if it changed
+    float policyCost(prob_t policy, int capacity) const; // estimated cost of a search with the policy
+    unsigned int tableHash(const string & name, const Slot* table) const; // hash value of a name in the given table
+    void newSeed(unsigned long long seed[2]); // draws a random SipHash key
+    const Slot* searchForFile(const File & file, Slot* table, int capacity, prob_t probing) const; // helper function for getFile
+    bool updateFile(const File & file, Slot* table, int capacity, prob_t probing, int block); // helper function for updateDiskBlock
+    bool removeFile(const File & file, Slot* table, int capacity, prob_t probing, bool & wasLive); // helper function for remove
+    bool insertFile(const File & file, Slot* table, int capacity, prob_t probing); // helper function for insert
+    void collectBlocks(const string & name, Slot* table, int capacity, prob_t probing, vector<int> & blocks) const; // helper function for findAll
+    void recordOp(stat_op_t op, bool hit) const; // adds the finished operation to the statistics
+    static size_t nameBytes(size_t length); // heap bytes used by a name of the given length
+    Slot* allocTable(int capacity);                 // allocates an empty table
+    void freeTable(Slot*& table, int capacity);     // deallocates a table and its long names
+    void fillSlot(Slot & slot, const File & file, unsigned int hash); // stores the file in a slot
+    void freeName(Slot & slot);                     // deallocates the long name of a slot
+    // copies the page of the bucket into the snapshots reading it, before a write
+    void preserve(const Slot* table, int index) {
+        if (!m_snapshots.empty() and table == m_currentTable) savePages(index);
+    }
+    void savePages(int index);
+    void detachSnapshots();  // copies every page left, before the table goes away
+    void dropDeleted(Slot* table, int index);       // empties a bucket holding a deleted entry
+    CountingBloomFilter* filterOf(const Slot* table) const; // negative lookup filter of the given table
+    static void cuckooBuckets(unsigned int hash, int capacity, int & first, int & second); // candidate buckets of a name
+    Slot* cuckooFind(const File & file, unsigned int hash, Slot* table, int capacity) const; // searches the candidate buckets
+    int cuckooPlace(unsigned int hash, Slot* table, int capacity); // makes room for a file, returns its slot
+    bool cuckooGrow(); // rebuilds the current table larger with a new seed once a file finds no room
+    bool cuckooFits(const Slot* table, int capacity) const; // no name has more than CUCKOONAMEMAX live files
+    CountingBloomFilter* buildFilter(const Slot* table, int capacity); // filter of the entries of a table
+    void freeFilter(CountingBloomFilter*& filter);
 };
 
 #endif
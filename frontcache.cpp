@@ -0,0 +1,97 @@
+// CMSC 341 - Fall 2024 - Project 4
+#include "frontcache.h"
+#include <cstring>
+
+FrontCache::FrontCache(int entries):
+m_hits(0),
+m_misses(0),
+m_evictions(0)
+{
+    m_numSets = 1;
+    while ((int)(m_numSets * CACHEWAYS) < entries) {
+        m_numSets <<= 1;
+    }
+    m_ways = new Way[m_numSets * CACHEWAYS];
+    m_hands = new unsigned char[m_numSets];
+    clear();
+}
+
+FrontCache::~FrontCache(){
+    delete[] m_ways;
+    delete[] m_hands;
+}
+
+/*
+FNV-1a of the name mixed with the block. It only spreads the files over the sets,
+a poor distribution costs cache misses, never long probe chains.
+*/
+unsigned int FrontCache::tagOf(const string & name, int block){
+    unsigned int hash = 2166136261u;
+    for (size_t i = 0; i < name.size(); i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    hash ^= (unsigned int)block * 2654435761u;
+    return hash ^ (hash >> 15);
+}
+
+bool FrontCache::matches(const Way & way, unsigned int tag, const string & name, int block){
+    return way.slot != nullptr and way.tag == tag and way.slot->occupied() and way.slot->getUsed()
+           and way.slot->getDiskBlock() == block and way.slot->nameEquals(name);
+}
+
+const Slot* FrontCache::find(const string & name, int block){
+    unsigned int tag = tagOf(name, block);
+    Way* set = m_ways + (tag & (m_numSets - 1)) * CACHEWAYS;
+    for (int i = 0; i < CACHEWAYS; i++) {
+        if (matches(set[i], tag, name, block)) {
+            set[i].referenced = 1;
+            m_hits++;
+            return set[i].slot;
+        }
+    }
+    m_misses++;
+    return nullptr;
+}
+
+void FrontCache::add(const string & name, int block, const Slot* slot){
+    unsigned int tag = tagOf(name, block);
+    unsigned int setIndex = tag & (m_numSets - 1);
+    Way* set = m_ways + setIndex * CACHEWAYS;
+    // a free way first
+    int victim = -1;
+    for (int i = 0; i < CACHEWAYS and victim == -1; i++) {
+        if (set[i].slot == nullptr) {
+            victim = i;
+        }
+    }
+    // then the first way the hand finds without its reference bit, clearing the bits it passes
+    if (victim == -1) {
+        unsigned char & hand = m_hands[setIndex];
+        while (set[hand].referenced) {
+            set[hand].referenced = 0;
+            hand = (hand + 1) % CACHEWAYS;
+        }
+        victim = hand;
+        hand = (hand + 1) % CACHEWAYS;
+        m_evictions++;
+    }
+    set[victim].slot = slot;
+    set[victim].tag = tag;
+    set[victim].referenced = 0;
+}
+
+void FrontCache::invalidate(const string & name, int block){
+    unsigned int tag = tagOf(name, block);
+    Way* set = m_ways + (tag & (m_numSets - 1)) * CACHEWAYS;
+    for (int i = 0; i < CACHEWAYS; i++) {
+        if (set[i].slot != nullptr and set[i].tag == tag) {
+            set[i].slot = nullptr;
+            set[i].referenced = 0;
+        }
+    }
+}
+
+void FrontCache::clear(){
+    memset(m_ways, 0, m_numSets * CACHEWAYS * sizeof(Way));
+    memset(m_hands, 0, m_numSets);
+}
@@ -0,0 +1,55 @@
+// CMSC 341 - Fall 2024 - Project 4
+#ifndef FRONTCACHE_H
+#define FRONTCACHE_H
+#include "filesys.h"
+#include <string>
+using namespace std;
+
+const int CACHEWAYS = 4; // ways per set, a set fills one 64 byte cache line
+
+// Small cache in front of FileSys::getFile for skewed access patterns.
+//
+// The cache is set associative: a cheap hash of the name and the block picks
+// a set of CACHEWAYS ways, and each way points at the table slot of a live file
+// found by an earlier getFile. A set is replaced by CLOCK: every hit sets the
+// way's reference bit, and the hand skips (and clears) referenced ways when it
+// looks for a victim. A hit checks the slot again before it is trusted, but
+// the pointers must not outlive the table, so FileSys clears the cache on every
+// rehash and invalidates the files that remove and updateDiskBlock change.
+class FrontCache{
+    public:
+    // the capacity is rounded up to a power of two number of sets
+    FrontCache(int entries);
+    ~FrontCache();
+    int capacity() const {return m_numSets * CACHEWAYS;}
+    // returns the slot of the live file (name, block), nullptr on a miss
+    const Slot* find(const string & name, int block);
+    // remembers the slot of the live file (name, block)
+    void add(const string & name, int block, const Slot* slot);
+    // forgets the file (name, block)
+    void invalidate(const string & name, int block);
+    // forgets every file, the table is going away
+    void clear();
+
+    unsigned long long hits() const {return m_hits;}
+    unsigned long long misses() const {return m_misses;}
+    unsigned long long evictions() const {return m_evictions;}
+    void resetCounters() {m_hits = m_misses = m_evictions = 0;}
+    private:
+    struct Way{
+        const Slot*  slot;       // nullptr if the way is free
+        unsigned int tag;        // hash of the name and the block
+        unsigned int referenced; // CLOCK reference bit
+    };
+    Way*           m_ways;       // m_numSets * CACHEWAYS ways, set by set
+    unsigned char* m_hands;      // CLOCK hand of every set
+    unsigned int   m_numSets;
+    unsigned long long m_hits;
+    unsigned long long m_misses;
+    unsigned long long m_evictions;
+
+    static unsigned int tagOf(const string & name, int block);
+    static bool matches(const Way & way, unsigned int tag, const string & name, int block);
+};
+
+#endif
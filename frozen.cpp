@@ -0,0 +1,185 @@
+// CMSC 341 - Fall 2024 - Project 4
+#include "frozen.h"
+#include <algorithm>
+#include <cstring>
+
+FrozenTable::FrozenTable(vector<pair<string, int> > files):
+m_seed(0)
+{
+    // a repeated pair has the same hash under every seed, no pilot could place both copies
+    sort(files.begin(), files.end());
+    files.erase(unique(files.begin(), files.end()), files.end());
+    m_numFiles = files.size();
+    m_numBuckets = m_numFiles / FROZENBUCKETKEYS + 1;
+
+    // a new seed changes every hash, so a build that gets stuck starts over with the next one
+    vector<unsigned long long> hashes(m_numFiles);
+    vector<int> order;
+    do {
+        m_seed++;
+        for (int i = 0; i < m_numFiles; i++) {
+            hashes[i] = hashOf(files[i].first, files[i].second);
+        }
+    } while (!build(hashes, order));
+
+    // the files are stored in position order
+    size_t nameBytes = 0;
+    for (int i = 0; i < m_numFiles; i++) {
+        nameBytes += files[i].first.size();
+    }
+    m_names.reserve(nameBytes);
+    m_offsets.reserve(m_numFiles + 1);
+    m_blocks.reserve(m_numFiles);
+    for (int position = 0; position < m_numFiles; position++) {
+        const pair<string, int> & file = files[order[position]];
+        m_offsets.push_back(m_names.size());
+        m_names.insert(m_names.end(), file.first.begin(), file.first.end());
+        m_blocks.push_back(file.second);
+    }
+    m_offsets.push_back(m_names.size());
+    // the files were sorted by name and block, order maps them back to their positions
+    m_byName.resize(m_numFiles);
+    for (int position = 0; position < m_numFiles; position++) {
+        m_byName[order[position]] = position;
+    }
+}
+
+int FrozenTable::find(const string & name, int block) const {
+    if (m_numFiles == 0) {
+        return -1;
+    }
+    unsigned long long hash = hashOf(name, block);
+    unsigned int pilot = m_pilots[((hash >> 32) * m_numBuckets) >> 32];
+    int position = (pilot & FROZENDIRECT) ? (int)(pilot & ~FROZENDIRECT) : positionOf(hash, pilot);
+    // the position holds some file of the table, a pair that isn't in it lands on another one
+    size_t length = m_offsets[position + 1] - m_offsets[position];
+    if (m_blocks[position] != block or length != name.size()
+        or memcmp(m_names.data() + m_offsets[position], name.data(), length) != 0) {
+        return -1;
+    }
+    return position;
+}
+
+void FrozenTable::findAll(const string & name, vector<int> & blocks, int & reads) const {
+    // binary search for the first file of the name, its other files follow it
+    int low = 0;
+    int high = m_numFiles;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        reads++;
+        if (compareName(m_byName[middle], name) < 0) {
+            low = middle + 1;
+        }else {
+            high = middle;
+        }
+    }
+    for (; low < m_numFiles and compareName(m_byName[low], name) == 0; low++) {
+        reads++;
+        blocks.push_back(m_blocks[m_byName[low]]);
+    }
+}
+
+string FrozenTable::nameAt(int position) const {
+    return string(m_names.data() + m_offsets[position], m_offsets[position + 1] - m_offsets[position]);
+}
+
+size_t FrozenTable::bytes() const {
+    return m_pilots.size() * sizeof(unsigned int) + m_offsets.size() * sizeof(unsigned int)
+           + m_blocks.size() * sizeof(int) + m_names.size() + m_byName.size() * sizeof(unsigned int);
+}
+
+int FrozenTable::compareName(int position, const string & name) const {
+    size_t length = m_offsets[position + 1] - m_offsets[position];
+    int result = memcmp(m_names.data() + m_offsets[position], name.data(), min(length, name.size()));
+    if (result != 0) {
+        return result;
+    }
+    return length < name.size() ? -1 : (length > name.size() ? 1 : 0);
+}
+
+/*
+FNV-1a of the name started from the seed, with the block mixed in by the
+MurmurHash3 finalizer. The upper half picks the bucket, the whole value is
+mixed with the pilot to pick the position.
+*/
+unsigned long long FrozenTable::hashOf(const string & name, int block) const {
+    unsigned long long hash = 14695981039346656037ULL ^ (m_seed * 0x9E3779B97F4A7C15ULL);
+    for (size_t i = 0; i < name.size(); i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 1099511628211ULL;
+    }
+    hash ^= (unsigned long long)(unsigned int)block << 17;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+int FrozenTable::positionOf(unsigned long long hash, unsigned int pilot) const {
+    unsigned long long mixed = hash ^ ((pilot + 1ULL) * 0x9E3779B97F4A7C15ULL);
+    mixed ^= mixed >> 29;
+    mixed *= 0xbf58476d1ce4e5b9ULL;
+    mixed ^= mixed >> 32;
+    return (int)(mixed % m_numFiles);
+}
+
+/*
+Places the buckets from the largest to the smallest. A bucket of several files
+tries pilots until all of its files land on free positions that differ from each
+other; with two files per bucket on average, about a quarter of the files end up
+in buckets of their own, so the last buckets of two still find room in a few dozen
+tries. Buckets of one file take the free positions left, in order.
+order[position] is set to the index of the file at the position.
+*/
+bool FrozenTable::build(const vector<unsigned long long> & hashes, vector<int> & order) {
+    vector<vector<int> > buckets(m_numBuckets);
+    for (int i = 0; i < m_numFiles; i++) {
+        buckets[((hashes[i] >> 32) * m_numBuckets) >> 32].push_back(i);
+    }
+    vector<int> bySize(m_numBuckets);
+    for (int i = 0; i < m_numBuckets; i++) {
+        bySize[i] = i;
+    }
+    stable_sort(bySize.begin(), bySize.end(), [&buckets](int first, int second) {
+        return buckets[first].size() > buckets[second].size();
+    });
+
+    m_pilots.assign(m_numBuckets, 0);
+    order.assign(m_numFiles, -1);
+    vector<int> positions;
+    size_t next = 0;
+    while (next < bySize.size() and buckets[bySize[next]].size() > 1) {
+        const vector<int> & bucket = buckets[bySize[next]];
+        bool placed = false;
+        for (int pilot = 0; pilot < FROZENMAXPILOT and !placed; pilot++) {
+            positions.clear();
+            placed = true;
+            for (size_t i = 0; i < bucket.size() and placed; i++) {
+                int position = positionOf(hashes[bucket[i]], pilot);
+                placed = order[position] == -1 and
+                         std::find(positions.begin(), positions.end(), position) == positions.end();
+                positions.push_back(position);
+            }
+            if (placed) {
+                m_pilots[bySize[next]] = pilot;
+                for (size_t i = 0; i < bucket.size(); i++) {
+                    order[positions[i]] = bucket[i];
+                }
+            }
+        }
+        if (!placed) {
+            return false; // two files with the same hash can't be told apart by any pilot
+        }
+        next++;
+    }
+    int freePosition = 0;
+    for (; next < bySize.size() and buckets[bySize[next]].size() == 1; next++) {
+        while (order[freePosition] != -1) {
+            freePosition++;
+        }
+        m_pilots[bySize[next]] = FROZENDIRECT | freePosition;
+        order[freePosition] = buckets[bySize[next]][0];
+    }
+    return true;
+}
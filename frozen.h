@@ -0,0 +1,52 @@
+// CMSC 341 - Fall 2024 - Project 4
+#ifndef FROZEN_H
+#define FROZEN_H
+#include <cstddef>
+#include <string>
+#include <vector>
+using namespace std;
+
+const int FROZENBUCKETKEYS = 2;         // average files per bucket of the perfect hash
+const unsigned int FROZENDIRECT = 1u << 31; // a bucket pilot that is the position of its one file
+const int FROZENMAXPILOT = 1 << 20;     // pilots tried for a bucket before the build starts over with a new seed
+
+// Read-only table of (name, block) pairs built on a minimal perfect hash.
+//
+// The n files are spread over n/2 buckets by their hash. Each bucket stores a
+// pilot, a number chosen when the table is built so that mixing it into the
+// hash sends every file of the bucket to a distinct position in [0, n). The
+// buckets are placed largest first; a bucket with one file takes any position
+// left, and its pilot is that position. A lookup hashes the pair, reads the
+// pilot of its bucket and compares the one file at the position, so there are
+// no empty slots, no deleted entries and no probing. The names are packed one
+// after the other in a single blob. The perfect hash needs the block, so findAll
+// searches a second array of the positions sorted by name and block instead.
+class FrozenTable{
+    public:
+    // builds the table from the pairs, a repeated pair is stored once
+    FrozenTable(vector<pair<string, int> > files);
+    // returns the position of the pair, -1 if it is not in the table
+    int find(const string & name, int block) const;
+    // appends the blocks of the files with the name in ascending order, adds the positions read to reads
+    void findAll(const string & name, vector<int> & blocks, int & reads) const;
+    int size() const {return m_numFiles;}
+    string nameAt(int position) const;
+    int blockAt(int position) const {return m_blocks[position];}
+    size_t bytes() const;
+    private:
+    int m_numFiles;
+    int m_numBuckets;
+    unsigned long long m_seed;      // the seed that let every bucket find a pilot
+    vector<unsigned int> m_pilots;  // one per bucket
+    vector<unsigned int> m_offsets; // start of each position's name in m_names, plus the end
+    vector<int> m_blocks;           // disk block of each position
+    vector<char> m_names;           // the names in position order
+    vector<unsigned int> m_byName;  // the positions in (name, block) order
+
+    unsigned long long hashOf(const string & name, int block) const;
+    int positionOf(unsigned long long hash, unsigned int pilot) const;
+    int compareName(int position, const string & name) const; // like string::compare
+    bool build(const vector<unsigned long long> & hashes, vector<int> & order);
+};
+
+#endif
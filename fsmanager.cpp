@@ -0,0 +1,153 @@
+// CMSC 341 - Fall 2024 - Project 4
+#include "fsmanager.h"
+#include <algorithm>
+#include <fstream>
+
+FileSysManager::FileSysManager(size_t budget, hash_fn hash, prob_t probing):
+m_arena(budget),
+m_hash(hash),
+m_probing(probing),
+m_hugePages(nullptr)
+{}
+
+FileSysManager::~FileSysManager(){
+    // the tables return their memory to the arena before it goes away
+    for (map<string, FileSys*>::iterator it = m_tables.begin(); it != m_tables.end(); it++) {
+        delete it->second;
+    }
+    m_tables.clear();
+    delete m_hugePages;
+}
+
+FileSys* FileSysManager::createTable(string tenant, int size){
+    if (m_tables.count(tenant) > 0) {
+        return nullptr;
+    }
+    // the capacity is rounded up to a prime by FileSys, MAXPRIME bounds it
+    size_t bytes = min(max(size, MINPRIME), MAXPRIME) * sizeof(Slot);
+    if (!m_arena.canAllocate(bytes)) {
+        return nullptr;
+    }
+    FileSys* table = new FileSys(size, m_hash, m_probing, &m_arena);
+    m_tables[tenant] = table;
+    return table;
+}
+
+bool FileSysManager::setHugePages(bool enabled, bool explicitPages){
+    if (!m_tables.empty()) {
+        return false;
+    }
+    HugePageAllocator* hugePages = enabled ? new HugePageAllocator(explicitPages) : nullptr;
+    if (!m_arena.setLargeAllocator(hugePages)) {
+        delete hugePages;
+        return false;
+    }
+    delete m_hugePages;
+    m_hugePages = hugePages;
+    return true;
+}
+
+FileSys* FileSysManager::getTable(string tenant) const{
+    map<string, FileSys*>::const_iterator it = m_tables.find(tenant);
+    if (it == m_tables.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+bool FileSysManager::dropTable(string tenant){
+    map<string, FileSys*>::iterator it = m_tables.find(tenant);
+    if (it == m_tables.end()) {
+        return false;
+    }
+    delete it->second;
+    m_tables.erase(it);
+    return true;
+}
+
+int FileSysManager::maintain(int maxRehashes){
+    // the tables close to the 0.5 threshold, fullest first
+    vector<pair<float, FileSys*> > candidates;
+    for (map<string, FileSys*>::iterator it = m_tables.begin(); it != m_tables.end(); it++) {
+        // a table at MAXPRIME is skipped, its rehash would only rebuild it at the same size
+        if (it->second->wantsGrow()) {
+            candidates.push_back(make_pair(it->second->lambda(), it->second));
+        }
+    }
+    sort(candidates.begin(), candidates.end(),
+         [](const pair<float, FileSys*> & a, const pair<float, FileSys*> & b){ return a.first > b.first; });
+
+    int grown = 0;
+    for (unsigned int i = 0; i < candidates.size() and grown < maxRehashes; i++) {
+        // rehashNow() checks the budget, a table that does not fit is skipped
+        if (candidates[i].second->rehashNow()) {
+            grown++;
+        }
+    }
+    return grown;
+}
+
+vector<pair<string, size_t> > FileSysManager::footprints() const{
+    vector<pair<string, size_t> > result;
+    for (map<string, FileSys*>::const_iterator it = m_tables.begin(); it != m_tables.end(); it++) {
+        result.push_back(make_pair(it->first, it->second->footprint()));
+    }
+    sort(result.begin(), result.end(),
+         [](const pair<string, size_t> & a, const pair<string, size_t> & b){ return a.second > b.second; });
+    return result;
+}
+
+void FileSysManager::dump() const{
+    cout << "Tables: " << m_tables.size() << ", bytes in use: " << m_arena.bytesInUse()
+         << " of " << m_arena.budget() << ", reserved: " << m_arena.bytesReserved() << endl;
+    vector<pair<string, size_t> > sizes = footprints();
+    for (unsigned int i = 0; i < sizes.size(); i++) {
+        FileSys* table = getTable(sizes[i].first);
+        cout << "[" << sizes[i].first << "] : " << sizes[i].second << " bytes, load "
+             << table->lambda() << ", deleted " << table->deletedRatio() << endl;
+    }
+}
+
+// Escapes a tenant name for a label value of the Prometheus text format
+static string labelValue(const string& name){
+    string value;
+    for (unsigned int i = 0; i < name.size(); i++) {
+        if (name[i] == '\\' or name[i] == '"') {
+            value += '\\';
+            value += name[i];
+        }
+        else if (name[i] == '\n') {
+            value += "\\n";
+        }
+        else {
+            value += name[i];
+        }
+    }
+    return value;
+}
+
+bool FileSysManager::exportStats(string filename) const{
+    ofstream out(filename.c_str());
+    if (!out) {
+        return false;
+    }
+    // the families of every table share their HELP and TYPE lines
+    StatFamilies families;
+    for (map<string, FileSys*>::const_iterator it = m_tables.begin(); it != m_tables.end(); it++) {
+        it->second->collectStats(families, "tenant=\"" + labelValue(it->first) + "\"");
+    }
+    families.write(out);
+    out << "# HELP filesys_manager_budget_bytes Memory budget shared by the tables." << endl;
+    out << "# TYPE filesys_manager_budget_bytes gauge" << endl;
+    out << "filesys_manager_budget_bytes " << m_arena.budget() << endl;
+    out << "# HELP filesys_manager_bytes_in_use Bytes handed out by the shared arena." << endl;
+    out << "# TYPE filesys_manager_bytes_in_use gauge" << endl;
+    out << "filesys_manager_bytes_in_use " << m_arena.bytesInUse() << endl;
+    out << "# HELP filesys_manager_bytes_reserved Bytes the shared arena took from the system." << endl;
+    out << "# TYPE filesys_manager_bytes_reserved gauge" << endl;
+    out << "filesys_manager_bytes_reserved " << m_arena.bytesReserved() << endl;
+    out << "# HELP filesys_manager_tables Number of tables." << endl;
+    out << "# TYPE filesys_manager_tables gauge" << endl;
+    out << "filesys_manager_tables " << m_tables.size() << endl;
+    return (bool)out;
+}
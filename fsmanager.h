@@ -0,0 +1,62 @@
+// CMSC 341 - Fall 2024 - Project 4
+#ifndef FSMANAGER_H
+#define FSMANAGER_H
+#include "filesys.h"
+#include "allocator.h"
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+using namespace std;
+
+
+// Owns one FileSys object per tenant. All of them allocate from one shared
+// BudgetArena, so the process has a single memory budget: an insert that would
+// need memory past the budget (for its entry or for the rehash it triggers)
+// is refused by the FileSys object. The manager also spreads the rehash work
+// over time: maintain() grows a bounded number of the fullest tables per call
+// before they reach the 0.5 load factor, so they do not all resize at once
+// on the request path.
+class FileSysManager{
+    public:
+    friend class Tester;
+    FileSysManager(size_t budget, hash_fn hash, prob_t probing = DEFPOLCY);
+    ~FileSysManager();
+    // creates the table of a tenant, returns nullptr if the tenant exists
+    // or the initial table does not fit in the budget
+    FileSys* createTable(string tenant, int size = MINPRIME);
+    // returns the table of a tenant, nullptr if there is none
+    FileSys* getTable(string tenant) const;
+    // destroys the table of a tenant and returns its memory to the arena
+    bool dropTable(string tenant);
+    int numTables() const {return m_tables.size();}
+
+    // grows at most maxRehashes tables whose load factor reached GROWLOAD and that a
+    // rehash would make bigger (see FileSys::wantsGrow), the fullest first, and
+    // returns the number of tables it grew
+    int maintain(int maxRehashes);
+
+    size_t budget() const {return m_arena.budget();}
+    void setBudget(size_t budget) {m_arena.setBudget(budget);}
+    size_t bytesInUse() const {return m_arena.bytesInUse();}
+    // backs the large table arrays with huge pages bound to the NUMA node of the
+    // thread that creates or grows the table (see HugePageAllocator); only allowed
+    // before the first table is created, returns false otherwise
+    bool setHugePages(bool enabled, bool explicitPages = false);
+    bool hasHugePages() const {return m_hugePages != nullptr;}
+    // returns (tenant, bytes) for every table, largest first
+    vector<pair<string, size_t> > footprints() const;
+    // prints the footprint, load factor and deleted ratio of every table
+    void dump() const;
+    // writes the counters of every table with a tenant label, plus the budget
+    // and the arena usage, in the Prometheus text format
+    bool exportStats(string filename) const;
+    private:
+    BudgetArena m_arena;            // shared by every table, declared first so it is destroyed last
+    hash_fn     m_hash;             // hash function of new tables
+    prob_t      m_probing;          // collision handling policy of new tables
+    map<string, FileSys*> m_tables; // tenant -> table
+    HugePageAllocator* m_hugePages; // source of the arena's large blocks, nullptr for malloc
+};
+
+#endif
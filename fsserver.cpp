@@ -0,0 +1,433 @@
+// CMSC 341 - Fall 2024 - Project 4
+#include "fsserver.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags != -1 and fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+FileSysServer::FileSysServer(FileSys* filesys, string path):
+m_filesys(filesys),
+m_path(path),
+m_listenFd(-1),
+m_epollFd(-1),
+m_wakeFd(-1),
+m_bound(false)
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+FileSysServer::~FileSysServer() {
+    for (size_t i = 0; i < m_connections.size(); i++) {
+        ::close(m_connections[i]->fd);
+        delete m_connections[i];
+    }
+    if (m_listenFd != -1) {
+        ::close(m_listenFd);
+    }
+    if (m_bound) {
+        unlink(m_path.c_str());
+    }
+    if (m_epollFd != -1) {
+        ::close(m_epollFd);
+    }
+    if (m_wakeFd != -1) {
+        ::close(m_wakeFd);
+    }
+}
+
+bool FileSysServer::listen() {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (m_path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    strcpy(address.sun_path, m_path.c_str());
+    // a socket file left by a server that is gone is replaced, one that still accepts is not
+    struct stat status;
+    if (lstat(m_path.c_str(), &status) == 0) {
+        if (!S_ISSOCK(status.st_mode)) {
+            return false;
+        }
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool live = probe != -1 and ::connect(probe, (sockaddr*)&address, sizeof(address)) == 0;
+        if (probe != -1) {
+            ::close(probe);
+        }
+        if (live) {
+            return false;
+        }
+        unlink(m_path.c_str());
+    }
+    m_listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_listenFd == -1) {
+        return false;
+    }
+    if (bind(m_listenFd, (sockaddr*)&address, sizeof(address)) == -1) {
+        return false;
+    }
+    m_bound = true;
+    if (::listen(m_listenFd, SOMAXCONN) == -1 or !setNonBlocking(m_listenFd)) {
+        return false;
+    }
+    m_epollFd = epoll_create1(0);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK);
+    if (m_epollFd == -1 or m_wakeFd == -1) {
+        return false;
+    }
+    // the listening socket and the eventfd are told apart by a null data pointer and the fd
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_listenFd, &event) == -1) {
+        return false;
+    }
+    event.data.ptr = &m_wakeFd;
+    return epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &event) != -1;
+}
+
+void FileSysServer::stop() {
+    unsigned long long one = 1;
+    if (write(m_wakeFd, &one, sizeof(one)) == -1) {
+        // the counter is already set, run() wakes up anyway
+    }
+}
+
+/*
+A round waits for events, reads every ready connection, dispatches what was read
+as one batch, and writes the answers. A connection whose answers don't fit in the
+socket buffer waits for EPOLLOUT and isn't read from until they are written, so a
+client that never reads can't make the server buffer without bound. The sends
+use MSG_NOSIGNAL, a client that went away is an error and not a SIGPIPE.
+*/
+void FileSysServer::run() {
+    epoll_event events[FSMAXEVENTS];
+    vector<Request> batch;
+    vector<Connection*> ready;
+    bool stopping = false;
+    while (!stopping) {
+        int count = epoll_wait(m_epollFd, events, FSMAXEVENTS, -1);
+        if (count == -1) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        batch.clear();
+        ready.clear();
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.ptr == nullptr) {
+                accept();
+            }else if (events[i].data.ptr == &m_wakeFd) {
+                stopping = true;
+            }else {
+                Connection* connection = (Connection*)events[i].data.ptr;
+                if ((events[i].events & EPOLLOUT) and !connection->out.empty()) {
+                    writeTo(connection);
+                }
+                if (connection->out.empty() and !connection->closing and !readFrom(connection, batch)) {
+                    connection->closing = true;
+                }
+                ready.push_back(connection);
+            }
+        }
+        if (!batch.empty()) {
+            dispatch(batch);
+            m_stats.batches++;
+        }
+        for (size_t i = 0; i < ready.size(); i++) {
+            if (!ready[i]->out.empty()) {
+                writeTo(ready[i]);
+            }
+            if (ready[i]->closing and ready[i]->out.empty()) {
+                close(ready[i]);
+            }
+        }
+    }
+}
+
+void FileSysServer::accept() {
+    while (true) {
+        int fd = ::accept(m_listenFd, nullptr, nullptr);
+        if (fd == -1) {
+            return;
+        }
+        setNonBlocking(fd);
+        Connection* connection = new Connection();
+        connection->fd = fd;
+        connection->closing = false;
+        connection->waiting = false;
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = connection;
+        epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event);
+        m_connections.push_back(connection);
+        m_stats.connections++;
+    }
+}
+
+/*
+Reads until the socket is drained, or FSREADLIMIT bytes were read so that one busy
+client can't hold up the others, and appends the complete requests to the batch.
+The connections are polled level-triggered, so one with more to read is ready again
+in the next round. A request cut in two by the socket stays in the input buffer for
+the next round. Returns false when the client closed the connection or sent a request
+that can't be read; the requests before it are still answered.
+*/
+bool FileSysServer::readFrom(Connection* connection, vector<Request> & batch) {
+    char buffer[FSREADBUFFER];
+    bool open = true;
+    size_t total = 0;
+    while (total < (size_t)FSREADLIMIT) {
+        ssize_t bytes = read(connection->fd, buffer, sizeof(buffer));
+        if (bytes > 0) {
+            m_stats.reads++;
+            connection->in.append(buffer, bytes);
+            total += bytes;
+            if (bytes < (ssize_t)sizeof(buffer)) break;
+        }else if (bytes == 0) {
+            open = false;
+            break;
+        }else {
+            if (errno != EAGAIN and errno != EWOULDBLOCK and errno != EINTR) open = false;
+            if (errno != EINTR) break;
+        }
+    }
+
+    size_t position = 0;
+    string & in = connection->in;
+    while (in.size() - position >= sizeof(FsRequestHeader)) {
+        Request request;
+        memcpy(&request.header, in.data() + position, sizeof(FsRequestHeader));
+        if (request.header.op >= NUMTRACEOPS or request.header.nameLength > FSMAXNAME) {
+            // the stream can't be followed past a bad header
+            request.connection = connection;
+            request.header.op = 0xff;
+            batch.push_back(request);
+            in.clear();
+            return false;
+        }
+        size_t length = sizeof(FsRequestHeader) + request.header.nameLength;
+        if (in.size() - position < length) {
+            break;
+        }
+        request.connection = connection;
+        request.name.assign(in.data() + position + sizeof(FsRequestHeader), request.header.nameLength);
+        batch.push_back(request);
+        position += length;
+    }
+    in.erase(0, position);
+    return open;
+}
+
+/*
+The whole batch goes through the table in one pass, each answer appended to the
+output of its connection. The requests of one connection stay in order since they
+were read in order.
+*/
+void FileSysServer::dispatch(const vector<Request> & batch) {
+    for (size_t i = 0; i < batch.size(); i++) {
+        const Request & request = batch[i];
+        FsResponse response;
+        response.op = request.header.op;
+        response.status = FSMISS;
+        response.used = 0;
+        response.reserved = 0;
+        response.block = request.header.block;
+        switch (request.header.op) {
+            case TRACEINSERT:
+                response.status = m_filesys->insert(File(request.name, request.header.block, true)) ? FSHIT : FSMISS;
+                break;
+            case TRACEREMOVE:
+                response.status = m_filesys->remove(File(request.name, request.header.block)) ? FSHIT : FSMISS;
+                break;
+            case TRACEGETFILE: {
+                File file = m_filesys->getFile(request.name, request.header.block);
+                response.status = file.getName().empty() ? FSMISS : FSHIT;
+                response.used = file.getUsed();
+                break;
+            }
+            case TRACEUPDATE:
+                response.status = m_filesys->updateDiskBlock(File(request.name, request.header.block), request.header.newBlock)
+                                  ? FSHIT : FSMISS;
+                break;
+            default:
+                response.status = FSERROR;
+                break;
+        }
+        request.connection->out.append((const char*)&response, sizeof(response));
+        m_stats.requests++;
+    }
+}
+
+void FileSysServer::writeTo(Connection* connection) {
+    size_t written = 0;
+    while (written < connection->out.size()) {
+        ssize_t bytes = send(connection->fd, connection->out.data() + written, connection->out.size() - written,
+                             MSG_NOSIGNAL);
+        m_stats.writes++;
+        if (bytes > 0) {
+            written += bytes;
+        }else if (bytes == -1 and errno == EINTR) {
+            continue;
+        }else {
+            if (bytes == -1 and errno != EAGAIN and errno != EWOULDBLOCK) {
+                connection->out.clear(); // the client is gone, nothing left to answer
+                connection->closing = true;
+                return;
+            }
+            break;
+        }
+    }
+    connection->out.erase(0, written);
+    // a connection with answers left waits for room in the socket buffer instead of being read
+    bool waiting = !connection->out.empty();
+    if (waiting != connection->waiting) {
+        epoll_event event;
+        event.events = waiting ? EPOLLOUT : EPOLLIN;
+        event.data.ptr = connection;
+        epoll_ctl(m_epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->waiting = waiting;
+    }
+}
+
+void FileSysServer::close(Connection* connection) {
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, connection->fd, nullptr);
+    ::close(connection->fd);
+    for (size_t i = 0; i < m_connections.size(); i++) {
+        if (m_connections[i] == connection) {
+            m_connections[i] = m_connections.back();
+            m_connections.pop_back();
+            break;
+        }
+    }
+    delete connection;
+}
+
+FileSysClient::FileSysClient():
+m_fd(-1),
+m_inStart(0)
+{}
+
+FileSysClient::~FileSysClient() {
+    close();
+}
+
+bool FileSysClient::connect(string path) {
+    close();
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    strcpy(address.sun_path, path.c_str());
+    m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_fd == -1) {
+        return false;
+    }
+    if (::connect(m_fd, (sockaddr*)&address, sizeof(address)) == -1) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void FileSysClient::close() {
+    if (m_fd != -1) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_out.clear();
+    m_in.clear();
+    m_inStart = 0;
+}
+
+bool FileSysClient::add(trace_op_t op, const string & name, int block, int newBlock) {
+    // the server hangs up on a longer name, and nameLength has 16 bits
+    if (name.size() > (size_t)FSMAXNAME) {
+        return false;
+    }
+    FsRequestHeader header;
+    header.op = op;
+    header.reserved = 0;
+    header.nameLength = (uint16_t)name.size();
+    header.block = block;
+    header.newBlock = newBlock;
+    m_out.append((const char*)&header, sizeof(header));
+    m_out.append(name);
+    return true;
+}
+
+bool FileSysClient::flush() {
+    size_t written = 0;
+    while (written < m_out.size()) {
+        ssize_t bytes = send(m_fd, m_out.data() + written, m_out.size() - written, MSG_NOSIGNAL);
+        if (bytes == -1 and errno == EINTR) {
+            continue;
+        }
+        if (bytes <= 0) {
+            return false;
+        }
+        written += bytes;
+    }
+    m_out.clear();
+    return true;
+}
+
+bool FileSysClient::receive(FsResponse & response) {
+    while (m_in.size() - m_inStart < sizeof(FsResponse)) {
+        // the buffer is compacted once everything in it was returned
+        if (m_inStart == m_in.size()) {
+            m_in.clear();
+            m_inStart = 0;
+        }
+        char buffer[FSREADBUFFER];
+        ssize_t bytes = read(m_fd, buffer, sizeof(buffer));
+        if (bytes == -1 and errno == EINTR) {
+            continue;
+        }
+        if (bytes <= 0) {
+            return false;
+        }
+        m_in.append(buffer, bytes);
+    }
+    memcpy(&response, m_in.data() + m_inStart, sizeof(FsResponse));
+    m_inStart += sizeof(FsResponse);
+    return true;
+}
+
+bool FileSysClient::call(trace_op_t op, const string & name, int block, int newBlock, FsResponse & response) {
+    return add(op, name, block, newBlock) and flush() and receive(response) and response.status != FSERROR;
+}
+
+const File FileSysClient::getFile(string name, int block) {
+    FsResponse response;
+    if (!call(TRACEGETFILE, name, block, 0, response) or response.status != FSHIT) {
+        return File();
+    }
+    return File(name, block, response.used != 0);
+}
+
+bool FileSysClient::insert(File file) {
+    FsResponse response;
+    return call(TRACEINSERT, file.getName(), file.getDiskBlock(), 0, response) and response.status == FSHIT;
+}
+
+bool FileSysClient::remove(File file) {
+    FsResponse response;
+    return call(TRACEREMOVE, file.getName(), file.getDiskBlock(), 0, response) and response.status == FSHIT;
+}
+
+bool FileSysClient::updateDiskBlock(File file, int block) {
+    FsResponse response;
+    return call(TRACEUPDATE, file.getName(), file.getDiskBlock(), block, response) and response.status == FSHIT;
+}
@@ -0,0 +1,132 @@
+// CMSC 341 - Fall 2024 - Project 4
+#ifndef FSSERVER_H
+#define FSSERVER_H
+#include "filesys.h"
+#include "trace.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Wire format of the FileSys server. A client writes requests back to back on the
+// socket without waiting for the answers (pipelining); the server answers every
+// request of a connection in order, so the responses carry no request id. The op
+// byte is a trace_op_t, the integers are in the byte order of the host since both
+// ends run on the same machine.
+struct FsRequestHeader{
+    uint8_t  op;
+    uint8_t  reserved;
+    uint16_t nameLength; // the name follows the header
+    int32_t  block;
+    int32_t  newBlock;   // only used by TRACEUPDATE
+};
+static_assert(sizeof(FsRequestHeader) == 12, "the request header is 12 bytes on the wire");
+
+const uint8_t FSMISS = 0;   // the file isn't there, or the change was refused
+const uint8_t FSHIT = 1;    // the file was found, or the change was made
+const uint8_t FSERROR = 2;  // the request can't be read, the server closes the connection after it
+
+struct FsResponse{
+    uint8_t  op;
+    uint8_t  status;    // FSMISS, FSHIT or FSERROR
+    uint8_t  used;      // TRACEGETFILE: the file found is live
+    uint8_t  reserved;
+    int32_t  block;     // the block of the request
+};
+static_assert(sizeof(FsResponse) == 8, "a response is 8 bytes on the wire");
+
+const int FSMAXNAME = 4096;       // longest name a request may carry
+const int FSREADBUFFER = 64 * 1024; // bytes read from a connection per read call
+const int FSREADLIMIT = 4 * FSREADBUFFER; // bytes read from a connection per round of the event loop
+const int FSMAXEVENTS = 64;       // connections handled per round of the event loop
+
+// Counters of a FileSysServer, to see how well the requests were batched.
+struct FsServerStats{
+    unsigned long long connections;   // connections accepted
+    unsigned long long requests;      // requests answered
+    unsigned long long batches;       // rounds of the event loop that dispatched requests
+    unsigned long long reads;         // read calls that returned data
+    unsigned long long writes;        // write calls
+};
+
+// Serves a FileSys object over a Unix domain socket.
+//
+// One thread runs an epoll loop over the listening socket and the connections.
+// Each round reads everything the ready connections have sent, decodes every
+// complete request, and dispatches the requests of all of them into the table in
+// one batch before a single write per connection sends the answers back. A client
+// that keeps many requests in flight thus costs a few system calls per batch
+// instead of two per request. The table is only touched by the server thread,
+// unless it has the background maintenance on.
+class FileSysServer{
+    public:
+    FileSysServer(FileSys* filesys, string path);
+    ~FileSysServer();
+    // binds the socket, returns false if it can't. A socket file no server answers on is
+    // replaced; a file of another kind or the socket of a live server is left alone
+    bool listen();
+    // runs the event loop until stop() is called
+    void run();
+    // makes run() return, from any thread
+    void stop();
+    FsServerStats stats() const {return m_stats;}
+    private:
+    struct Connection{
+        int    fd;
+        string in;          // bytes read and not decoded yet
+        string out;         // responses not written yet
+        bool   closing;     // close once out is written
+        bool   waiting;     // out didn't fit, polled for EPOLLOUT instead of EPOLLIN
+    };
+    struct Request{
+        Connection* connection;
+        FsRequestHeader header;
+        string name;
+    };
+
+    FileSys*    m_filesys;
+    string      m_path;
+    int         m_listenFd;
+    int         m_epollFd;
+    int         m_wakeFd;   // eventfd stop() writes to
+    bool        m_bound;    // the socket file at m_path is ours to remove
+    vector<Connection*> m_connections;
+    FsServerStats m_stats;
+
+    void accept();
+    bool readFrom(Connection* connection, vector<Request> & batch);
+    void dispatch(const vector<Request> & batch);
+    void writeTo(Connection* connection);
+    void close(Connection* connection);
+};
+
+// Client of a FileSysServer. Requests are queued with add() and sent together with
+// flush(); the answers come back in order with receive(). The synchronous calls
+// send one request and wait for its answer.
+class FileSysClient{
+    public:
+    FileSysClient();
+    ~FileSysClient();
+    bool connect(string path);
+    void close();
+    bool isConnected() const {return m_fd != -1;}
+    // queues a request, returns false without queuing it if the name is longer than FSMAXNAME
+    bool add(trace_op_t op, const string & name, int block, int newBlock = 0);
+    // writes the queued requests, returns false if the connection is gone
+    bool flush();
+    // waits for the next response, returns false if the connection is gone
+    bool receive(FsResponse & response);
+    const File getFile(string name, int block);
+    bool insert(File file);
+    bool remove(File file);
+    bool updateDiskBlock(File file, int block);
+    private:
+    int    m_fd;
+    string m_out;       // queued requests
+    string m_in;        // bytes received and not returned yet
+    size_t m_inStart;
+
+    bool call(trace_op_t op, const string & name, int block, int newBlock, FsResponse & response);
+};
+
+#endif
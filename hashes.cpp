@@ -0,0 +1,142 @@
+// CMSC 341 - Fall 2024 - Project 4
+#include "hashes.h"
+#include <cstdint>
+#include <cstring>
+
+unsigned int djb33Hash(string str) {
+    unsigned int val = 0;
+    for (unsigned int i = 0; i < str.length(); i++)
+        val = val * 33 + str[i];
+    return val;
+}
+
+unsigned int fnv1aHash(string str) {
+    uint32_t val = 2166136261u;
+    for (unsigned int i = 0; i < str.length(); i++) {
+        val ^= (unsigned char)str[i];
+        val *= 16777619u;
+    }
+    return val;
+}
+
+static uint32_t rotl32(uint32_t x, int r) {
+    return (x << r) | (x >> (32 - r));
+}
+
+unsigned int murmur3Hash(string str) {
+    const uint32_t c1 = 0xcc9e2d51;
+    const uint32_t c2 = 0x1b873593;
+    const unsigned char* data = (const unsigned char*)str.data();
+    size_t length = str.length();
+    size_t blocks = length / 4;
+    uint32_t h = 0;
+
+    for (size_t i = 0; i < blocks; i++) {
+        uint32_t k;
+        memcpy(&k, data + i * 4, sizeof(k));
+        k *= c1;
+        k = rotl32(k, 15);
+        k *= c2;
+        h ^= k;
+        h = rotl32(h, 13);
+        h = h * 5 + 0xe6546b64;
+    }
+
+    // the remaining 0 to 3 bytes
+    const unsigned char* tail = data + blocks * 4;
+    uint32_t k = 0;
+    switch (length & 3) {
+        case 3: k ^= tail[2] << 16; // fall through
+        case 2: k ^= tail[1] << 8;  // fall through
+        case 1: k ^= tail[0];
+                k *= c1; k = rotl32(k, 15); k *= c2; h ^= k;
+    }
+
+    // finalization mix
+    h ^= length;
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+static uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// one SipRound of the SipHash state
+static void sipRound(uint64_t & v0, uint64_t & v1, uint64_t & v2, uint64_t & v3) {
+    v0 += v1; v1 = rotl64(v1, 13); v1 ^= v0; v0 = rotl64(v0, 32);
+    v2 += v3; v3 = rotl64(v3, 16); v3 ^= v2;
+    v0 += v3; v3 = rotl64(v3, 21); v3 ^= v0;
+    v2 += v1; v1 = rotl64(v1, 17); v1 ^= v2; v2 = rotl64(v2, 32);
+}
+
+unsigned long long sipHash(const unsigned long long key[2], const string & str) {
+    uint64_t v0 = 0x736f6d6570736575ULL ^ key[0];
+    uint64_t v1 = 0x646f72616e646f6dULL ^ key[1];
+    uint64_t v2 = 0x6c7967656e657261ULL ^ key[0];
+    uint64_t v3 = 0x7465646279746573ULL ^ key[1];
+    const unsigned char* data = (const unsigned char*)str.data();
+    size_t length = str.length();
+    size_t blocks = length / 8;
+
+    for (size_t i = 0; i < blocks; i++) {
+        uint64_t m = 0;
+        for (int b = 0; b < 8; b++) {
+            m |= (uint64_t)data[i * 8 + b] << (8 * b); // little-endian regardless of the host
+        }
+        v3 ^= m;
+        sipRound(v0, v1, v2, v3);
+        sipRound(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+
+    // the last block holds the remaining 0 to 7 bytes and the length
+    uint64_t m = (uint64_t)(length & 0xff) << 56;
+    for (size_t b = 0; b < (length & 7); b++) {
+        m |= (uint64_t)data[blocks * 8 + b] << (8 * b);
+    }
+    v3 ^= m;
+    sipRound(v0, v1, v2, v3);
+    sipRound(v0, v1, v2, v3);
+    v0 ^= m;
+
+    v2 ^= 0xff;
+    for (int i = 0; i < 4; i++) {
+        sipRound(v0, v1, v2, v3);
+    }
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+hash_fn hashByName(string name) {
+    if (name == "djb33") return djb33Hash;
+    if (name == "fnv1a") return fnv1aHash;
+    if (name == "murmur3") return murmur3Hash;
+    return nullptr;
+}
+
+const char* hashNames() {
+    return "djb33 fnv1a murmur3";
+}
+
+const char* policyName(prob_t policy) {
+    switch (policy) {
+        case QUADRATIC: return "QUADRATIC";
+        case DOUBLEHASH: return "DOUBLEHASH";
+        case LINEAR: return "LINEAR";
+        case CUCKOO: return "CUCKOO";
+    }
+    return "UNKNOWN";
+}
+
+bool parsePolicy(string name, prob_t & policy) {
+    if (name == "QUADRATIC") policy = QUADRATIC;
+    else if (name == "DOUBLEHASH") policy = DOUBLEHASH;
+    else if (name == "LINEAR") policy = LINEAR;
+    else if (name == "CUCKOO") policy = CUCKOO;
+    else return false;
+    return true;
+}
@@ -0,0 +1,34 @@
+// CMSC 341 - Fall 2024 - Project 4
+#ifndef HASHES_H
+#define HASHES_H
+#include "filesys.h"
+#include <string>
+using namespace std;
+
+// Built-in string hash functions with the hash_fn signature, for the tools
+// that compare hash functions against each other, and the policy names the
+// tools share.
+
+// the textbook hash: val = val * 33 + c (same as hashCode in driver.cpp)
+unsigned int djb33Hash(string str);
+// 32-bit FNV-1a
+unsigned int fnv1aHash(string str);
+// 32-bit MurmurHash3 with a zero seed
+unsigned int murmur3Hash(string str);
+
+// SipHash-2-4 of the string under the 128-bit key {key[0], key[1]}. Without the
+// key, an attacker cannot build names that collide, which makes it the keyed
+// hash of FileSys::setSeededHash().
+unsigned long long sipHash(const unsigned long long key[2], const string & str);
+
+// returns the built-in hash function with the given name, nullptr if unknown
+hash_fn hashByName(string name);
+// space separated names accepted by hashByName
+const char* hashNames();
+
+// returns the name of a probing policy as the tools print it, e.g. "LINEAR"
+const char* policyName(prob_t policy);
+// sets policy to the probing policy with the given name, returns false if it is unknown
+bool parsePolicy(string name, prob_t & policy);
+
+#endif
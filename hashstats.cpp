@@ -0,0 +1,337 @@
+// CMSC 341 - Fall 2024 - Project 4
+// Hash function analyzer. A corpus of file names (one per line, or a synthetic
+// one) is hashed with each candidate hash function, and for every capacity the
+// spread of the names over the buckets is reported: the chi-squared statistic
+// against a uniform spread (about 1 per degree of freedom for a good hash), the
+// fullest bucket and the share of empty buckets. The names are then inserted
+// into a FileSys table of that capacity under every probing policy, and the
+// probe lengths the table counts for insert, getFile hits and getFile misses are
+// shown next to the textbook values for an ideal hash. The table counts the home
+// bucket twice when it is taken, so its probes run a little above those values,
+// and an insert counts the search for a duplicate as well.
+// The hashing throughput tells what a better spread costs.
+// djb33 is the hashCode function of driver.cpp and mytest.cpp.
+//     ./filesys_hashstats names.txt
+//     ./filesys_hashstats --synth=paths --count=50000 --capacity=10007,99991
+//     ./filesys_hashstats --synth=colliding --hash=djb33,siphash --load=0.3
+#include "filesys.h"
+#include "hashes.h"
+#include "latency.h"
+#include "random.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <vector>
+using namespace std;
+
+// Settings taken from the command line.
+struct HashStatsOptions {
+    string corpus;          // file with one name per line, empty for a synthetic corpus
+    string synth;           // random, paths or colliding
+    int count;              // names of the synthetic corpus
+    int seed;               // seed of the synthetic corpus
+    vector<string> hashes;  // hash functions to compare
+    vector<int> capacities; // table capacities, rounded up to a prime like FileSys does
+    double load;            // share of the buckets the names fill
+};
+
+// SipHash with a fixed key, to compare the keyed hash with the others
+unsigned int sipHash32(string str){
+    static const unsigned long long key[2] = {0x0706050403020100ULL, 0x0f0e0d0c0b0a0908ULL};
+    return (unsigned int)sipHash(key, str);
+}
+
+hash_fn candidateByName(const string & name){
+    if (name == "siphash") return sipHash32;
+    return hashByName(name);
+}
+
+void usage(const char* program){
+    cerr << "usage: " << program << " <names file> [--hash=NAME,...] [--capacity=N,...] [--load=F]" << endl;
+    cerr << "       " << program << " --synth=random|paths|colliding [--count=N] [--seed=N] [--hash=NAME,...]"
+         << " [--capacity=N,...] [--load=F]" << endl;
+    cerr << "hash functions: " << hashNames() << " siphash" << endl;
+}
+
+vector<string> splitList(const string & list){
+    vector<string> items;
+    stringstream stream(list);
+    string item;
+    while (getline(stream, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+// the capacity a FileSys table asked for size gets
+int tableCapacity(int size){
+    if (size < MINPRIME) size = MINPRIME;
+    if (size > MAXPRIME) size = MAXPRIME;
+    while (true) {
+        bool prime = true;
+        for (int i = 2; (long)i * i <= size; i++) {
+            if (size % i == 0) {
+                prime = false;
+                break;
+            }
+        }
+        if (prime) return size;
+        size++;
+    }
+}
+
+// Reads the names of the corpus, or makes them up, without duplicates.
+bool loadCorpus(const HashStatsOptions & options, vector<string> & names){
+    vector<string> all;
+    if (!options.corpus.empty()) {
+        ifstream in(options.corpus);
+        if (!in) {
+            return false;
+        }
+        string line;
+        while (getline(in, line)) {
+            if (!line.empty() and line.back() == '\r') line.pop_back();
+            if (!line.empty()) all.push_back(line);
+        }
+    }else if (options.synth == "colliding") {
+        Random random(0, 1);
+        random.setSeed(options.seed);
+        random.getCollidingNames(all, options.count);
+    }else if (options.synth == "paths") {
+        Random random(0, 1);
+        random.setSeed(options.seed);
+        for (int i = 0; i < options.count; i++) {
+            all.push_back(random.getPathName(i, 3, 8));
+        }
+    }else if (options.synth == "random") {
+        Random chars(97, 122);
+        Random length(6, 14);
+        chars.setSeed(options.seed);
+        length.setSeed(options.seed + 1);
+        for (int i = 0; i < options.count; i++) {
+            all.push_back(chars.getRandString(length.getRandNum()));
+        }
+    }else {
+        return false;
+    }
+    set<string> seen;
+    for (size_t i = 0; i < all.size(); i++) {
+        if (seen.insert(all[i]).second) names.push_back(all[i]);
+    }
+    return true;
+}
+
+// Hashes the corpus over and over for at least 50 ms and returns the nanoseconds per name.
+double hashNanos(hash_fn hash, const vector<string> & names){
+    volatile unsigned int sink = 0;
+    long hashed = 0;
+    long long elapsed = 0;
+    BenchClock::time_point start = BenchClock::now();
+    while (elapsed < 50000000) {
+        unsigned int sum = 0;
+        for (size_t i = 0; i < names.size(); i++) {
+            sum += hash(names[i]);
+        }
+        sink = sink + sum;
+        hashed += names.size();
+        elapsed = elapsedNanos(start, BenchClock::now());
+    }
+    return (double)elapsed / hashed;
+}
+
+// The upper bound of the histogram bucket below which 99% of the operations fall.
+string probePercentile(const FileSysStats & stats, stat_op_t op){
+    unsigned long long total = stats.hits[op] + stats.misses[op];
+    unsigned long long cumulative = 0;
+    for (int bucket = 0; bucket < PROBEBUCKETS; bucket++) {
+        cumulative += stats.probeHistogram[op][bucket];
+        if (cumulative >= 0.99 * total) {
+            return bucket == PROBEBUCKETS - 1 ? ">" + to_string(1 << (bucket - 1)) : "<=" + to_string(1 << bucket);
+        }
+    }
+    return "-";
+}
+
+double meanProbes(const FileSysStats & stats, stat_op_t op){
+    unsigned long long total = stats.hits[op] + stats.misses[op];
+    return total > 0 ? (double)stats.probeTotal[op] / total : 0.0;
+}
+
+// Textbook probes of a search at load factor alpha with an ideal hash: linear probing,
+// and uniform hashing for the other open addressing policies.
+void expectedProbes(prob_t policy, double alpha, double & hit, double & miss){
+    if (policy == LINEAR) {
+        hit = 0.5 * (1 + 1 / (1 - alpha));
+        miss = 0.5 * (1 + 1 / ((1 - alpha) * (1 - alpha)));
+    }else {
+        hit = alpha > 0 ? log(1 / (1 - alpha)) / alpha : 1.0;
+        miss = 1 / (1 - alpha);
+    }
+}
+
+// Prints the spread of the names over the buckets of one capacity for every hash.
+void reportSpread(const vector<string> & names, const vector<string> & hashes, int capacity, int count){
+    double expected = (double)count / capacity;
+    cout << "spread over " << capacity << " buckets (" << count << " names, "
+         << fixed << setprecision(2) << expected << " per bucket):" << endl;
+    cout << left << setw(12) << "hash" << right << setw(12) << "chi2/df" << setw(8) << "max"
+         << setw(10) << "empty%" << setw(10) << "ideal%" << endl;
+    for (size_t h = 0; h < hashes.size(); h++) {
+        hash_fn hash = candidateByName(hashes[h]);
+        vector<int> buckets(capacity, 0);
+        for (int i = 0; i < count; i++) {
+            buckets[hash(names[i]) % capacity]++;
+        }
+        double chi2 = 0;
+        int fullest = 0;
+        int empty = 0;
+        for (int b = 0; b < capacity; b++) {
+            chi2 += (buckets[b] - expected) * (buckets[b] - expected) / expected;
+            fullest = max(fullest, buckets[b]);
+            empty += buckets[b] == 0;
+        }
+        cout << left << setw(12) << hashes[h] << right << setw(12) << setprecision(3) << chi2 / (capacity - 1)
+             << setw(8) << fullest << setw(10) << setprecision(1) << 100.0 * empty / capacity
+             << setw(10) << 100.0 * exp(-expected) << endl;
+    }
+}
+
+// Inserts the names into a table of one capacity under every policy and prints the probes.
+void reportProbes(const vector<string> & names, const vector<string> & hashes, int capacity, int count){
+    double alpha = (double)count / capacity;
+    cout << "probes at load " << setprecision(2) << alpha << ":" << endl;
+    cout << left << setw(12) << "hash" << setw(12) << "policy" << right << setw(9) << "insert"
+         << setw(9) << "hit" << setw(9) << "ideal" << setw(8) << "p99" << setw(9) << "miss"
+         << setw(9) << "ideal" << setw(8) << "p99" << setw(8) << "reseed" << endl;
+    const prob_t policies[4] = {LINEAR, QUADRATIC, DOUBLEHASH, CUCKOO};
+    for (size_t h = 0; h < hashes.size(); h++) {
+        hash_fn hash = candidateByName(hashes[h]);
+        for (int p = 0; p < 4; p++) {
+            FileSys filesys(capacity, hash, policies[p]);
+            for (int i = 0; i < count; i++) {
+                filesys.insert(File(names[i], DISKMIN + i % (DISKMAX - DISKMIN + 1)));
+            }
+            FileSysStats inserted = filesys.getStats();
+            filesys.resetStats();
+            for (int i = 0; i < count; i++) {
+                filesys.getFile(names[i], DISKMIN + i % (DISKMAX - DISKMIN + 1));
+            }
+            FileSysStats hits = filesys.getStats();
+            filesys.resetStats();
+            // names that are not in the table, with a home bucket of their own
+            for (int i = 0; i < count; i++) {
+                filesys.getFile(names[i] + "~", DISKMIN);
+            }
+            FileSysStats misses = filesys.getStats();
+
+            cout << left << setw(12) << hashes[h] << setw(12) << policyName(policies[p]) << right << setprecision(2)
+                 << setw(9) << meanProbes(inserted, STATINSERT) << setw(9) << meanProbes(hits, STATFIND);
+            if (policies[p] == CUCKOO) {
+                cout << setw(9) << "-";
+            }else {
+                double hit, miss;
+                expectedProbes(policies[p], alpha, hit, miss);
+                cout << setw(9) << hit;
+            }
+            cout << setw(8) << probePercentile(hits, STATFIND) << setw(9) << meanProbes(misses, STATFIND);
+            if (policies[p] == CUCKOO) {
+                cout << setw(9) << "-";
+            }else {
+                double hit, miss;
+                expectedProbes(policies[p], alpha, hit, miss);
+                cout << setw(9) << miss;
+            }
+            // a flooded chain makes the table change to SipHash, the probes after it aren't the hash's
+            cout << setw(8) << probePercentile(misses, STATFIND) << setw(8) << (inserted.reseedCount > 0 ? "yes" : "no")
+                 << endl;
+        }
+    }
+}
+
+int main(int argc, char** argv){
+    HashStatsOptions options;
+    options.count = 20000;
+    options.seed = 10;
+    options.hashes = splitList("djb33,fnv1a,murmur3,siphash");
+    options.capacities.push_back(1009);
+    options.capacities.push_back(10007);
+    options.capacities.push_back(MAXPRIME);
+    options.load = 0.5;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg.rfind("--synth=", 0) == 0) {
+            options.synth = arg.substr(strlen("--synth="));
+        }else if (arg.rfind("--count=", 0) == 0) {
+            options.count = max(1, atoi(arg.c_str() + strlen("--count=")));
+        }else if (arg.rfind("--seed=", 0) == 0) {
+            options.seed = atoi(arg.c_str() + strlen("--seed="));
+        }else if (arg.rfind("--hash=", 0) == 0) {
+            options.hashes = splitList(arg.substr(strlen("--hash=")));
+        }else if (arg.rfind("--capacity=", 0) == 0) {
+            vector<string> sizes = splitList(arg.substr(strlen("--capacity=")));
+            options.capacities.clear();
+            for (size_t s = 0; s < sizes.size(); s++) {
+                options.capacities.push_back(atoi(sizes[s].c_str()));
+            }
+        }else if (arg.rfind("--load=", 0) == 0) {
+            options.load = atof(arg.c_str() + strlen("--load="));
+        }else if (arg.rfind("--", 0) != 0 and options.corpus.empty()) {
+            options.corpus = arg;
+        }else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    // a load past 0.5 would rehash the table to another capacity
+    if ((options.corpus.empty() == options.synth.empty()) or options.hashes.empty() or options.capacities.empty()
+        or options.load <= 0 or options.load > 0.5) {
+        usage(argv[0]);
+        return 1;
+    }
+    for (size_t h = 0; h < options.hashes.size(); h++) {
+        if (candidateByName(options.hashes[h]) == nullptr) {
+            cerr << "unknown hash function " << options.hashes[h] << ", expected one of: " << hashNames() << " siphash" << endl;
+            return 1;
+        }
+    }
+
+    vector<string> names;
+    if (!loadCorpus(options, names) or names.empty()) {
+        cerr << "cannot read names from " << (options.corpus.empty() ? "--synth=" + options.synth : options.corpus) << endl;
+        return 1;
+    }
+    size_t bytes = 0;
+    for (size_t i = 0; i < names.size(); i++) {
+        bytes += names[i].size();
+    }
+    cout << "corpus: " << (options.corpus.empty() ? options.synth + " (synthetic)" : options.corpus) << ", "
+         << names.size() << " distinct names, " << fixed << setprecision(1) << (double)bytes / names.size()
+         << " bytes on average" << endl;
+
+    cout << left << setw(12) << "hash" << right << setw(12) << "ns/name" << setw(10) << "GB/s" << endl;
+    for (size_t h = 0; h < options.hashes.size(); h++) {
+        double nanos = hashNanos(candidateByName(options.hashes[h]), names);
+        cout << left << setw(12) << options.hashes[h] << right << setw(12) << setprecision(1) << nanos
+             << setw(10) << setprecision(2) << (double)bytes / names.size() / nanos << endl;
+    }
+
+#ifndef FILESYS_STATS
+    cout << "built without FILESYS_STATS, the probe lengths are not counted" << endl;
+#endif
+    for (size_t c = 0; c < options.capacities.size(); c++) {
+        int capacity = tableCapacity(options.capacities[c]);
+        // the names fill the buckets up to the load, or as far as the corpus goes
+        int count = (int)min((long)names.size(), (long)(options.load * capacity));
+        if (count == 0) continue;
+        cout << endl;
+        reportSpread(names, options.hashes, capacity, count);
+#ifdef FILESYS_STATS
+        reportProbes(names, options.hashes, capacity, count);
+#endif
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+// CMSC 341 - Fall 2024 - Project 4
+#ifndef LATENCY_H
+#define LATENCY_H
+#include <algorithm>
+#include <chrono>
+#include <vector>
+using namespace std;
+typedef std::chrono::steady_clock BenchClock;
+
+// Collects per-operation latencies (in nanoseconds) so the benchmark
+// programs can report a latency distribution and not only an average.
+class LatencyStats {
+public:
+    LatencyStats(){ m_sorted = true; m_total = 0; }
+    void reserve(size_t count) {m_samples.reserve(count);}
+    void clear() {m_samples.clear(); m_total = 0; m_sorted = true;}
+    void add(long long nanos){
+        m_samples.push_back(nanos);
+        m_total += nanos;
+        m_sorted = false;
+    }
+    // merges the samples of another recorder into this one
+    void add(const LatencyStats & other){
+        m_samples.insert(m_samples.end(), other.m_samples.begin(), other.m_samples.end());
+        m_total += other.m_total;
+        m_sorted = false;
+    }
+    size_t count() const {return m_samples.size();}
+    long long total() const {return m_total;}
+    double mean() const {
+        return m_samples.empty() ? 0.0 : (double)m_total / m_samples.size();
+    }
+    // returns the latency below which the fraction p (0.0 - 1.0) of samples fall
+    long long percentile(double p){
+        if (m_samples.empty()) return 0;
+        if (!m_sorted){
+            sort(m_samples.begin(), m_samples.end());
+            m_sorted = true;
+        }
+        size_t index = (size_t)(p * (m_samples.size() - 1) + 0.5);
+        return m_samples[min(index, m_samples.size() - 1)];
+    }
+    // operations per second given the wall time the samples were taken in
+    static double throughput(size_t ops, long long wallNanos){
+        return wallNanos > 0 ? ops * 1e9 / wallNanos : 0.0;
+    }
+private:
+    vector<long long> m_samples;
+    long long m_total;
+    bool m_sorted;
+};
+
+// returns nanoseconds elapsed between two clock readings
+inline long long elapsedNanos(BenchClock::time_point start, BenchClock::time_point end){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+#endif
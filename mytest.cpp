@@ -1,137 +1,28 @@
 #include "filesys.h"
-#include <math.h>
+#include "fsmanager.h"
+#include "frontcache.h"
+#include "blockalloc.h"
+#include "frozen.h"
+#include "shmfilesys.h"
+#include "fsserver.h"
+#include "random.h"
+#include "trace.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <algorithm>
-#include <random>
+#include <iterator>
+#include <set>
+#include <thread>
+#include <chrono>
 #include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
 using namespace std;
 
-enum RANDOM {UNIFORMINT, UNIFORMREAL, NORMAL, SHUFFLE};
-class Random {
-public:
-    Random(){}
-    Random(int min, int max, RANDOM type=UNIFORMINT, int mean=50, int stdev=20) : m_min(min), m_max(max), m_type(type)
-    {
-        if (type == NORMAL){
-            //the case of NORMAL to generate integer numbers with normal distribution
-            m_generator = std::mt19937(m_device());
-            //the data set will have the mean of 50 (default) and standard deviation of 20 (default)
-            //the mean and standard deviation can change by passing new values to constructor 
-            m_normdist = std::normal_distribution<>(mean,stdev);
-        }
-        else if (type == UNIFORMINT) {
-            //the case of UNIFORMINT to generate integer numbers
-            // Using a fixed seed value generates always the same sequence
-            // of pseudorandom numbers, e.g. reproducing scientific experiments
-            // here it helps us with testing since the same sequence repeats
-            m_generator = std::mt19937(10);// 10 is the fixed seed value
-            m_unidist = std::uniform_int_distribution<>(min,max);
-        }
-        else if (type == UNIFORMREAL) { //the case of UNIFORMREAL to generate real numbers
-            m_generator = std::mt19937(10);// 10 is the fixed seed value
-            m_uniReal = std::uniform_real_distribution<double>((double)min,(double)max);
-        }
-        else { //the case of SHUFFLE to generate every number only once
-            m_generator = std::mt19937(m_device());
-        }
-    }
-    void setSeed(int seedNum){
-        // we have set a default value for seed in constructor
-        // we can change the seed by calling this function after constructor call
-        // this gives us more randomness
-        m_generator = std::mt19937(seedNum);
-    }
-    void init(int min, int max){
-        m_min = min;
-        m_max = max;
-        m_type = UNIFORMINT;
-        m_generator = std::mt19937(10);// 10 is the fixed seed value
-        m_unidist = std::uniform_int_distribution<>(min,max);
-    }
-    void getShuffle(vector<int> & array){
-        // this function provides a list of all values between min and max
-        // in a random order, this function guarantees the uniqueness
-        // of every value in the list
-        // the user program creates the vector param and passes here
-        // here we populate the vector using m_min and m_max
-        for (int i = m_min; i<=m_max; i++){
-            array.push_back(i);
-        }
-        shuffle(array.begin(),array.end(),m_generator);
-    }
-
-    void getShuffle(int array[]){
-        // this function provides a list of all values between min and max
-        // in a random order, this function guarantees the uniqueness
-        // of every value in the list
-        // the param array must be of the size (m_max-m_min+1)
-        // the user program creates the array and pass it here
-        vector<int> temp;
-        for (int i = m_min; i<=m_max; i++){
-            temp.push_back(i);
-        }
-        std::shuffle(temp.begin(), temp.end(), m_generator);
-        vector<int>::iterator it;
-        int i = 0;
-        for (it=temp.begin(); it != temp.end(); it++){
-            array[i] = *it;
-            i++;
-        }
-    }
-
-    int getRandNum(){
-        // this function returns integer numbers
-        // the object must have been initialized to generate integers
-        int result = 0;
-        if(m_type == NORMAL){
-            //returns a random number in a set with normal distribution
-            //we limit random numbers by the min and max values
-            result = m_min - 1;
-            while(result < m_min || result > m_max)
-                result = m_normdist(m_generator);
-        }
-        else if (m_type == UNIFORMINT){
-            //this will generate a random number between min and max values
-            result = m_unidist(m_generator);
-        }
-        return result;
-    }
-
-    double getRealRandNum(){
-        // this function returns real numbers
-        // the object must have been initialized to generate real numbers
-        double result = m_uniReal(m_generator);
-        // a trick to return numbers only with two deciaml points
-        // for example if result is 15.0378, function returns 15.03
-        // to round up we can use ceil function instead of floor
-        result = std::floor(result*100.0)/100.0;
-        return result;
-    }
-
-    string getRandString(int size){
-        // the parameter size specifies the length of string we ask for
-        // to use ASCII char the number range in constructor must be set to 97 - 122
-        // and the Random type must be UNIFORMINT (it is default in constructor)
-        string output = "";
-        for (int i=0;i<size;i++){
-            output = output + (char)getRandNum();
-        }
-        return output;
-    }
-    
-    int getMin(){return m_min;}
-    int getMax(){return m_max;}
-    private:
-    int m_min;
-    int m_max;
-    RANDOM m_type;
-    std::random_device m_device;
-    std::mt19937 m_generator;
-    std::normal_distribution<> m_normdist;//normal distribution
-    std::uniform_int_distribution<> m_unidist;//integer uniform distribution
-    std::uniform_real_distribution<double> m_uniReal;//real uniform distribution
-
-};
-
 unsigned int hashCode(const string str) {
    unsigned int val = 0 ;
    const unsigned int thirtyThree = 33 ;  // magic number from textbook
@@ -140,6 +31,16 @@ unsigned int hashCode(const string str) {
    return val ;
 }
 
+// the hash of the name without its last character, ten files named file<n>0 - file<n>9 share it
+unsigned int groupHash(const string str) {
+   return hashCode(str.substr(0, str.size() - 1));
+}
+
+// Hashes the first three characters only, names that start the same share a probe sequence
+unsigned int prefixHash(const string str) {
+   return hashCode(str.substr(0, 3));
+}
+
 
 class Tester {
     
@@ -173,6 +74,94 @@ public:
     // Test the rehash completion after triggering rehash due to delete ratio, i.e. all live data is transferred to the new table and the old table is removed.
     bool testRehashCompletionRemoveEdge();
 
+    // Test the instrumentation counters and their Prometheus export after a few operations.
+    bool testStatsCountersNorm();
+    // Test the rehash counters after a rehash triggered by the load factor.
+    bool testStatsRehashEdge();
+    // Test recording operations to a trace file and reading them back.
+    bool testTraceRecordReplayNorm();
+    // Test reading a truncated trace and a record with a name length out of bounds
+    bool testTraceDamagedEdge();
+    // Test the Zipfian, path name and colliding name generators of the Random class.
+    bool testWorkloadGeneratorsNorm();
+    // Test switching between the user hash function and the seeded hash.
+    bool testSeededHashNorm();
+    // Test that a flooded probe chain of colliding names triggers a reseed and rehash.
+    bool testHashFloodReseedEdge();
+    // Test that a table manager keeps every tenant within the shared memory budget
+    bool testManagerBudgetEdge();
+    // Test that the table manager grows the fullest tables first, a few at a time
+    bool testManagerMaintainNorm();
+    // Test that the exported counters of all tenants share one HELP and TYPE line per metric
+    bool testManagerExportNorm();
+    // Test the packed slot encoding at the limits of the block range and of the inline names
+    bool testPackedSlotEdge();
+    // Test prefix and range scans of the ordered index
+    bool testOrderedIndexNorm();
+    // Test the ordered index when it is enabled late and changes under a cursor
+    bool testOrderedIndexEdge();
+    // Test finding every disk block of a name
+    bool testFindAllNorm();
+    // Test that the front cache answers repeated lookups
+    bool testFrontCacheNorm();
+    // Test that remove, updateDiskBlock and rehash invalidate the front cache
+    bool testFrontCacheInvalidationEdge();
+    // Test that the negative lookup filter answers searches for missing files
+    bool testNegativeFilterNorm();
+    // Test that a table with the negative lookup filter behaves like one without it
+    bool testNegativeFilterEdge();
+    // Test that CUCKOO lookups look at two buckets and the stash at most
+    bool testCuckooNorm();
+    // Test the CUCKOO policy against a probing table, with colliding names and a full stash
+    bool testCuckooEdge();
+    // Test that createFile takes the lowest free block and remove gives it back
+    bool testBlockAllocatorNorm();
+    // Test the block allocator when the blocks run out and with runs across words
+    bool testBlockAllocatorEdge();
+    // Test that a frozen table finds its live files and refuses changes
+    bool testFreezeNorm();
+    // Test freezing an empty table and a large one with colliding names
+    bool testFreezeEdge();
+    // Test a shared table written by one process and read by another
+    bool testShmFileSysNorm();
+    // Test the limits of a shared table and a reader running next to the writer
+    bool testShmFileSysEdge();
+    // Test that removes and inserts of a shared table reuse the name area instead of using it up
+    bool testShmNameChurnEdge();
+    // Test that a rehash leaves its transfer to the maintenance thread
+    bool testBackgroundMaintenanceNorm();
+    // Test the background maintenance with several threads and many deleted entries
+    bool testBackgroundMaintenanceEdge();
+    // Test the settings and freeze() while the maintenance thread runs
+    bool testBackgroundSettersEdge();
+    // Test the in-place purge of the deleted entries for a normal case
+    bool testPurgeInPlaceNorm();
+    // Test the in-place purge of the deleted entries for an edge case
+    bool testPurgeInPlaceEdge();
+    // Test the adaptive probing policy for a normal case
+    bool testAdaptivePolicyNorm();
+    // Test the adaptive probing policy for an edge case
+    bool testAdaptivePolicyEdge();
+    // Test that the adaptive policy switches under a workload of lookups only
+    bool testAdaptiveReadOnlyNorm();
+    // Test the huge page allocator for a normal case
+    bool testHugePageAllocatorNorm();
+    // Test the huge page allocator for an edge case
+    bool testHugePageAllocatorEdge();
+    // Test the point-in-time snapshots for a normal case
+    bool testSnapshotNorm();
+    // Test the point-in-time snapshots for an edge case
+    bool testSnapshotEdge();
+    // the pipelined requests of the Unix socket server
+    bool testServerNorm();
+    // requests split on the socket, bad requests and clients that hang up
+    bool testServerEdge();
+    // deleted entries that pile up on the same files
+    bool testRemoveChurnEdge();
+    // removing a file that is deleted already, in the current and the old table
+    bool testRemoveTwiceEdge();
+    // deleted entries that take most of the buckets under the 0.8 deleted ratio
+    bool testOccupiedPurgeEdge();
 };
 
 int main() {
@@ -255,6 +244,314 @@ int main() {
         cout << "\n\tfailed." << endl;
     }
 
+    cout << "Testing the instrumentation counters and their export for a normal case:";
+    if (t.testStatsCountersNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the rehash counters after a rehash for an edge case:";
+    if (t.testStatsRehashEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing recording a trace and reading it back for a normal case:";
+    if (t.testTraceRecordReplayNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing reading a damaged trace for an edge case:";
+    if (t.testTraceDamagedEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the Zipfian, path name and colliding name generators for a normal case:";
+    if (t.testWorkloadGeneratorsNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing switching to the seeded hash and back for a normal case:";
+    if (t.testSeededHashNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the reseed after a flood of colliding names for an edge case:";
+    if (t.testHashFloodReseedEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the shared memory budget of the table manager for an edge case:";
+    if (t.testManagerBudgetEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the staggered growth of the table manager for a normal case:";
+    if (t.testManagerMaintainNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the exported counters of the table manager for a normal case:";
+    if (t.testManagerExportNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the packed slot encoding for an edge case:";
+    if (t.testPackedSlotEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing prefix and range scans of the ordered index for a normal case:";
+    if (t.testOrderedIndexNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the ordered index under changes for an edge case:";
+    if (t.testOrderedIndexEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing finding every disk block of a name for a normal case:";
+    if (t.testFindAllNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the front cache of getFile for a normal case:";
+    if (t.testFrontCacheNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the front cache invalidation for an edge case:";
+    if (t.testFrontCacheInvalidationEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the negative lookup filter for a normal case:";
+    if (t.testNegativeFilterNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the negative lookup filter against a plain table for an edge case:";
+    if (t.testNegativeFilterEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the CUCKOO policy for a normal case:";
+    if (t.testCuckooNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the CUCKOO policy for an edge case:";
+    if (t.testCuckooEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the block allocator for a normal case:";
+    if (t.testBlockAllocatorNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the block allocator for an edge case:";
+    if (t.testBlockAllocatorEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the frozen table for a normal case:";
+    if (t.testFreezeNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the frozen table for an edge case:";
+    if (t.testFreezeEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the shared memory table for a normal case:";
+    if (t.testShmFileSysNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the shared memory table for an edge case:";
+    if (t.testShmFileSysEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the name area of a shared table under churn for an edge case:";
+    if (t.testShmNameChurnEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the background maintenance for a normal case:";
+    if (t.testBackgroundMaintenanceNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the background maintenance for an edge case:";
+    if (t.testBackgroundMaintenanceEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the settings of a table with the background maintenance for an edge case:";
+    if (t.testBackgroundSettersEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the in-place purge for a normal case:";
+    if (t.testPurgeInPlaceNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the in-place purge for an edge case:";
+    if (t.testPurgeInPlaceEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the adaptive probing policy for a normal case:";
+    if (t.testAdaptivePolicyNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the adaptive probing policy for an edge case:";
+    if (t.testAdaptivePolicyEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the adaptive probing policy under lookups only for a normal case:";
+    if (t.testAdaptiveReadOnlyNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the huge page allocator for a normal case:";
+    if (t.testHugePageAllocatorNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the huge page allocator for an edge case:";
+    if (t.testHugePageAllocatorEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the snapshots for a normal case:";
+    if (t.testSnapshotNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the snapshots for an edge case:";
+    if (t.testSnapshotEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the Unix socket server for a normal case:";
+    if (t.testServerNorm()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the Unix socket server for an edge case:";
+    if (t.testServerEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing removes and inserts of the same files for an edge case:";
+    if (t.testRemoveChurnEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the remove of a deleted file for an edge case:";
+    if (t.testRemoveTwiceEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
+    cout << "Testing the purge of a table full of deleted entries for an edge case:";
+    if (t.testOccupiedPurgeEdge()) {
+        cout << "\n\tpassed!" << endl;
+    }else {
+        cout << "\n\tfailed." << endl;
+    }
+
 }
 
 
@@ -457,3 +754,1733 @@ bool Tester::testRehashCompletionRemoveEdge() {
     } 
     return false;
 }
+
+bool Tester::testStatsCountersNorm() {
+    FileSys fs(MINPRIME, hashCode, LINEAR);
+
+    // Insert, find, update and remove a few files
+    fs.insert(File("file1", DISKMIN));
+    fs.insert(File("file2", DISKMIN + 1));
+    fs.insert(File("file1", DISKMIN));  // duplicate, rejected
+    fs.getFile("file1", DISKMIN);       // hit
+    fs.getFile("missing", DISKMIN);     // miss
+    fs.remove(File("file2", DISKMIN + 1));
+
+    FileSysStats stats = fs.getStats();
+    string filename = "mytest_stats.prom";
+    bool exported = fs.exportStats(filename);
+    ifstream in(filename.c_str());
+    string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+    std::remove(filename.c_str());
+    // The export should contain the probe histograms of every operation type
+    if (!exported or text.find("filesys_probe_length_bucket{op=\"find\",le=\"+Inf\"}") == string::npos) {
+        return false;
+    }
+
+#ifdef FILESYS_STATS
+    unsigned long long finds = 0;
+    for (int bucket = 0; bucket < PROBEBUCKETS; bucket++) {
+        finds += stats.probeHistogram[STATFIND][bucket];
+    }
+    // Every operation is counted once, as a hit or as a miss,
+    if (stats.hits[STATINSERT] == 2 and stats.misses[STATINSERT] == 1
+    and stats.hits[STATFIND] == 1 and stats.misses[STATFIND] == 1 and finds == 2
+    and stats.hits[STATREMOVE] == 1
+    // every operation probes at least one bucket,
+    and stats.probeTotal[STATFIND] >= 2
+    // no rehash has happened yet,
+    and stats.rehashCount == 0
+    // and the memory held by the table is accounted for.
+    and stats.bytesInUse >= MINPRIME * sizeof(Slot)) {
+        return true;
+    }
+    return false;
+#else
+    // Without FILESYS_STATS the counters stay at zero
+    return stats.hits[STATINSERT] == 0 and stats.rehashCount == 0;
+#endif
+}
+
+bool Tester::testStatsRehashEdge() {
+    FileSys fs(MINPRIME, hashCode, LINEAR);
+
+    // Inserting more than 50% capacity amt of keys to trigger rehash
+    int keysAmt = (0.5 * MINPRIME + 1);
+    for (int i = 0; i < keysAmt; i++) {
+        fs.insert(File("file" + to_string(i), DISKMIN + i));
+    }
+    FileSysStats stats = fs.getStats();
+
+#ifdef FILESYS_STATS
+    // One rehash moved every live entry, and the transfers are not counted as inserts
+    if (stats.rehashCount == 1
+    and stats.entriesMoved == (unsigned long long)(keysAmt)
+    and stats.hits[STATINSERT] == (unsigned long long)(keysAmt)
+    and stats.bytesAllocated > stats.bytesInUse) {
+        return true;
+    }
+    return false;
+#else
+    return stats.rehashCount == 0;
+#endif
+}
+
+bool Tester::testTraceRecordReplayNorm() {
+    FileSys fs(MINPRIME, hashCode, LINEAR);
+    TraceWriter writer;
+    string filename = "mytest_trace.bin";
+    if (!writer.open(filename)) {
+        return false;
+    }
+
+    // Record a few operations, with a repeated name and a block out of range
+    fs.setTrace(&writer);
+    fs.insert(File("file1", DISKMIN));
+    fs.insert(File("file1", DISKMAX));
+    fs.getFile("file1", DISKMIN);
+    fs.updateDiskBlock(File("file1", DISKMAX), DISKMIN + 5);
+    fs.remove(File("file2", -7));
+    fs.setTrace(nullptr);
+    fs.getFile("file1", DISKMIN); // not recorded
+    writer.close();
+
+    TraceReader reader;
+    vector<TraceRecord> records;
+    bool opened = reader.open(filename);
+    long read = reader.readAll(records);
+    std::remove(filename.c_str());
+
+    // The trace should hold the recorded calls in order with their arguments
+    if (opened and read == 5 and records.size() == 5
+    and records[0].op == TRACEINSERT and records[0].name == "file1" and records[0].block == DISKMIN
+    and records[1].op == TRACEINSERT and records[1].block == DISKMAX
+    and records[2].op == TRACEGETFILE and records[2].name == "file1"
+    and records[3].op == TRACEUPDATE and records[3].block == DISKMAX and records[3].newBlock == DISKMIN + 5
+    and records[4].op == TRACEREMOVE and records[4].name == "file2" and records[4].block == -7) {
+        return true;
+    }
+    return false;
+}
+
+bool Tester::testTraceDamagedEdge() {
+    string filename = "mytest_damaged.bin";
+    TraceWriter writer;
+    if (!writer.open(filename)) {
+        return false;
+    }
+    writer.record(TRACEINSERT, "file1", DISKMIN);
+    writer.record(TRACEUPDATE, "file2", DISKMIN, DISKMAX);
+    // a name the reader could not take back is not recorded
+    writer.record(TRACEINSERT, string(TRACEMAXNAME + 1, 'a'), DISKMIN);
+    bool skipped = writer.count() == 2;
+    writer.close();
+
+    // Cut the last byte, the new block of the update is gone
+    ifstream in(filename.c_str(), ios::binary);
+    string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+    ofstream out(filename.c_str(), ios::binary | ios::trunc);
+    out.write(bytes.data(), bytes.size() - 1);
+    out.close();
+    TraceReader truncated;
+    vector<TraceRecord> records;
+    bool cut = truncated.open(filename) and truncated.readAll(records) == -1
+               and truncated.isDamaged() and records.size() == 1;
+
+    // A new name whose length is over TRACEMAXNAME is damaged, not a 4 GiB allocation
+    out.open(filename.c_str(), ios::binary | ios::trunc);
+    out.write(TRACEMAGIC, strlen(TRACEMAGIC));
+    const char record[] = {(char)TRACEINSERT, 0, (char)0xff, (char)0xff, (char)0xff, (char)0xff, 0x0f};
+    out.write(record, sizeof(record));
+    out.close();
+    TraceReader oversized;
+    TraceRecord first;
+    bool rejected = oversized.open(filename) and !oversized.next(first) and oversized.isDamaged();
+    std::remove(filename.c_str());
+    return skipped and cut and rejected;
+}
+
+bool Tester::testWorkloadGeneratorsNorm() {
+    // Zipfian numbers stay in range and the smallest value is the most popular
+    Random zipf(0, 99, ZIPF);
+    int counts[100] = {0};
+    bool inRange = true;
+    for (int i = 0; i < 10000; i++) {
+        int num = zipf.getRandNum();
+        if (num < 0 or num > 99) {
+            inRange = false;
+        }else {
+            counts[num]++;
+        }
+    }
+    bool skewed = counts[0] > counts[1] and counts[1] > counts[10] and counts[0] > 10000 / 10;
+
+    // Colliding names are distinct and all have the same hash value
+    Random adversary(0, 1);
+    vector<string> names;
+    adversary.getCollidingNames(names, 100);
+    bool colliding = (names.size() == 100);
+    for (unsigned int i = 1; i < names.size(); i++) {
+        if (hashCode(names[i]) != hashCode(names[0])
+        or find(names.begin(), names.begin() + i, names[i]) != names.begin() + i) {
+            colliding = false;
+        }
+    }
+
+    // Path names share a prefix of depth directories
+    Random paths(0, 1);
+    string path = paths.getPathName(7, 3, 4);
+    bool pathForm = (path.size() == 13 and path[0] == '/' and path.substr(6) == "/file_7");
+
+    return inRange and skewed and colliding and pathForm;
+}
+
+bool Tester::testSeededHashNorm() {
+    FileSys fs(MINPRIME, hashCode, DOUBLEHASH);
+
+    // Switching an empty table to the seeded hash happens in place
+    fs.setSeededHash(true);
+    bool seededEmpty = fs.isSeededHash() and fs.m_oldTable == nullptr and fs.m_currentSize == 0;
+    for (int i = 0; i < 20; i++) {
+        fs.insert(File("file" + to_string(i), DISKMIN + i));
+    }
+
+    // Switching back rehashes the entries with the user hash function
+    fs.setSeededHash(false);
+    bool found = true;
+    for (int i = 0; i < 20; i++) {
+        if (!(fs.getFile("file" + to_string(i), DISKMIN + i) == File("file" + to_string(i), DISKMIN + i))) {
+            found = false;
+        }
+    }
+    return seededEmpty and !fs.isSeededHash() and found and fs.m_currentSize == 20;
+}
+
+bool Tester::testHashFloodReseedEdge() {
+    FileSys fs(MINPRIME, hashCode, LINEAR);
+
+    // Names that all collide under hashCode build one long probe chain
+    Random adversary(0, 1);
+    vector<string> names;
+    adversary.getCollidingNames(names, 2 * FLOODPROBES);
+    for (unsigned int i = 0; i < names.size(); i++) {
+        fs.insert(File(names[i], DISKMIN + i));
+    }
+
+    // The long chain should have switched the table to the seeded hash,
+    bool seeded = fs.isSeededHash();
+    // every name should still be found,
+    bool found = true;
+    for (unsigned int i = 0; i < names.size(); i++) {
+        if (!(fs.getFile(names[i], DISKMIN + i) == File(names[i], DISKMIN + i))) {
+            found = false;
+        }
+    }
+    // and the chain of the last name is short again.
+    int chain = 0;
+    unsigned int hash = fs.tableHash(names.back(), fs.m_currentTable);
+    for (int index = hash % fs.m_currentCap; fs.m_currentTable[index].occupied(); index = (index + 1) % fs.m_currentCap) {
+        chain++;
+    }
+    FileSysStats stats = fs.getStats();
+#ifdef FILESYS_STATS
+    bool counted = (stats.reseedCount == 1);
+#else
+    bool counted = (stats.reseedCount == 0);
+#endif
+    // The seeded hash stays through the next regular rehash, until the user hash is asked for
+    fs.rehashNow();
+    bool kept = fs.isSeededHash();
+    fs.setSeededHash(false);
+    bool restored = !fs.isSeededHash() and fs.getFile(names[0], DISKMIN) == File(names[0], DISKMIN);
+    return seeded and found and chain < FLOODPROBES and counted and kept and restored;
+}
+
+bool Tester::testManagerBudgetEdge() {
+    // A budget that fits the initial tables of two tenants, not a third
+    size_t tableBytes = MINPRIME * sizeof(Slot);
+    FileSysManager manager(2 * tableBytes + tableBytes / 2, hashCode, LINEAR);
+    bool created = manager.createTable("a") != nullptr and manager.createTable("b") != nullptr;
+    bool rejected = manager.createTable("c") == nullptr and manager.createTable("a") == nullptr;
+
+    // Inserts stop once the entries no longer fit, the table stays usable
+    FileSys* table = manager.getTable("a");
+    int inserted = 0;
+    for (int i = 0; i < MINPRIME; i++) {
+        if (table->insert(File("file" + to_string(i), DISKMIN + i))) inserted++;
+    }
+    bool bounded = inserted > 0 and inserted < MINPRIME / 2 + 1 and manager.bytesInUse() <= manager.budget();
+    bool found = table->getFile("file0", DISKMIN) == File("file0", DISKMIN);
+
+    // Dropping a table returns its memory, so the third tenant fits now
+    bool dropped = manager.dropTable("a") and !manager.dropTable("a");
+    bool reused = manager.createTable("c") != nullptr and manager.numTables() == 2;
+    manager.dropTable("b");
+    manager.dropTable("c");
+    return created and rejected and bounded and found and dropped and reused and manager.bytesInUse() == 0;
+}
+
+bool Tester::testManagerMaintainNorm() {
+    FileSysManager manager(1 << 20, hashCode, LINEAR);
+    const int tenants = 4;
+    // Tenant i is filled to a load factor of 0.1 * (i + 1), with names too long
+    // to be stored inline so that the fuller tables have larger footprints
+    for (int i = 0; i < tenants; i++) {
+        FileSys* table = manager.createTable("t" + to_string(i));
+        for (int j = 0; j < (MINPRIME * (i + 1)) / 10 + 1; j++) {
+            table->insert(File("/tenant/data/file" + to_string(j), DISKMIN + j));
+        }
+    }
+    // The footprints are listed largest first, the fullest tenant on top
+    vector<pair<string, size_t> > sizes = manager.footprints();
+    bool accounted = sizes.size() == tenants and sizes[0].first == "t3";
+    for (unsigned int i = 1; i < sizes.size(); i++) {
+        if (sizes[i].second > sizes[i - 1].second) accounted = false;
+    }
+
+    // Only the fullest table (0.4) is over GROWLOAD; one call grows it and nothing else
+    int oldCap = manager.getTable("t3")->m_currentCap;
+    bool first = manager.maintain(1) == 1 and manager.getTable("t3")->m_currentCap > oldCap
+                 and manager.getTable("t2")->m_currentCap == MINPRIME;
+    bool idle = manager.maintain(1) == 0;
+    bool intact = manager.getTable("t3")->getFile("/tenant/data/file0", DISKMIN) == File("/tenant/data/file0", DISKMIN);
+
+    // A table at MAXPRIME can't grow any more, a rehash would only rebuild it at
+    // the same size, so maintain() leaves it alone even over GROWLOAD
+    FileSysManager large(16 << 20, hashCode, LINEAR);
+    FileSys* full = large.createTable("full", MAXPRIME);
+    for (int j = 0; j < MAXPRIME / 2 - 5000; j++) {
+        full->insert(File("file" + to_string(j), DISKMIN + j % (DISKMAX - DISKMIN)));
+    }
+    int fullCap = full->m_currentCap;
+    bool capped = full->lambda() >= GROWLOAD and !full->wantsGrow()
+                  and large.maintain(1) == 0 and full->m_currentCap == fullCap;
+    return accounted and first and idle and intact and capped;
+}
+
+bool Tester::testManagerExportNorm() {
+    FileSysManager manager(1 << 20, hashCode, LINEAR);
+    manager.createTable("plain")->insert(File("file1", DISKMIN));
+    manager.createTable("quote\"back\\slash")->insert(File("file1", DISKMIN));
+    string filename = "mytest_manager.prom";
+    bool exported = manager.exportStats(filename);
+    ifstream in(filename.c_str());
+    string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    in.close();
+    std::remove(filename.c_str());
+
+    // Every metric has its HELP and TYPE lines once, with the samples of both tenants under it
+    int types = 0;
+    bool unique = true;
+    size_t position = 0;
+    while ((position = text.find("# TYPE ", position)) != string::npos) {
+        size_t end = text.find(' ', position + 7);
+        string name = text.substr(position + 7, end - position - 7);
+        if (text.find("# TYPE " + name + " ", end) != string::npos) unique = false;
+        position = end;
+        types++;
+    }
+    size_t load = text.find("# TYPE filesys_load_factor gauge\n");
+    bool grouped = load != string::npos
+                   and text.find("filesys_load_factor{tenant=\"plain\"}", load) != string::npos
+                   // the quote and the backslash of the tenant name are escaped
+                   and text.find("filesys_load_factor{tenant=\"quote\\\"back\\\\slash\"}", load) != string::npos;
+    return exported and types > 0 and unique and grouped;
+}
+
+bool Tester::testPackedSlotEdge() {
+    FileSys fs(MINPRIME, hashCode, LINEAR);
+    size_t tableBytes = fs.footprint();
+    // The block range ends and a name of exactly SLOTINLINE bytes stay inline
+    string inlineName(SLOTINLINE, 'a');
+    string longName(SLOTINLINE + 1, 'b');
+    fs.insert(File("short", DISKMIN));
+    fs.insert(File(inlineName, DISKMAX));
+    bool inlined = fs.footprint() == tableBytes;
+    // a longer name takes a heap buffer of its length
+    fs.insert(File(longName, DISKMIN + 1));
+    bool heaped = fs.footprint() == tableBytes + longName.size();
+
+    bool found = fs.getFile("short", DISKMIN) == File("short", DISKMIN)
+                 and fs.getFile(inlineName, DISKMAX) == File(inlineName, DISKMAX)
+                 and fs.getFile(longName, DISKMIN + 1) == File(longName, DISKMIN + 1)
+                 and fs.getFile(inlineName, DISKMIN).getName().empty();
+    // Deleting keeps the entry as a tombstone, the flag lives in the packed word
+    fs.remove(File(longName, DISKMIN + 1));
+    File removed = fs.getFile(longName, DISKMIN + 1);
+    bool tombstone = removed.getName() == longName and !removed.getUsed();
+    // A new block outside [DISKMIN-DISKMAX] does not fit the packed word
+    bool rejected = !fs.updateDiskBlock(File("short", DISKMIN), DISKMAX + 1);
+    return sizeof(Slot) == 24 and inlined and heaped and found and tombstone and rejected;
+}
+
+bool Tester::testOrderedIndexNorm() {
+    FileSys fs(MINPRIME, hashCode, DOUBLEHASH);
+    fs.setOrderedIndex(true);
+    // Path names that share directory prefixes, enough of them to rehash a few times
+    Random paths(0, 1);
+    vector<File> files;
+    int expected = 0; // files under /a/
+    for (int i = 0; i < 500; i++) {
+        File file(paths.getPathName(i, 2, 3), DISKMIN + i);
+        fs.insert(file);
+        files.push_back(file);
+    }
+    // Remove every fifth file
+    for (unsigned int i = 0; i < files.size(); i += 5) {
+        fs.remove(files[i]);
+    }
+    for (unsigned int i = 0; i < files.size(); i++) {
+        if (i % 5 != 0 and files[i].getName().compare(0, 3, "/a/") == 0) expected++;
+    }
+
+    // The prefix scan lists exactly the live files under /a/, in name order
+    FileCursor cursor = fs.scanPrefix("/a/");
+    File file;
+    File previous("", 0);
+    int listed = 0;
+    bool ordered = true, found = true;
+    while (cursor.next(file)) {
+        if (file.getName() < previous.getName()) ordered = false;
+        if (!(fs.getFile(file.getName(), file.getDiskBlock()) == file)) found = false;
+        previous = file;
+        listed++;
+    }
+    // A range scan stops before its end
+    FileCursor range = fs.scanRange("/a/", "/b/");
+    int ranged = 0;
+    while (range.next(file)) ranged++;
+    return expected > 0 and listed == expected and ranged == expected and ordered and found;
+}
+
+bool Tester::testOrderedIndexEdge() {
+    FileSys fs(MINPRIME, hashCode, QUADRATIC);
+    fs.insert(File("/x/1", DISKMIN));
+    fs.insert(File("/x/2", DISKMIN));
+    fs.insert(File("/y/1", DISKMIN));
+    File file;
+    // Without an index the cursors are empty
+    FileCursor none = fs.scanPrefix("/x/");
+    bool empty = !fs.hasOrderedIndex() and !none.next(file);
+
+    // Enabling the index picks up the files already in the table
+    fs.setOrderedIndex(true);
+    FileCursor cursor = fs.scanPrefix("/x/");
+    bool first = cursor.next(file) and file == File("/x/1", DISKMIN);
+    // The cursor sees the changes made between two calls
+    fs.remove(File("/x/2", DISKMIN));
+    fs.insert(File("/x/3", DISKMIN));
+    bool second = cursor.next(file) and file == File("/x/3", DISKMIN);
+    bool done = !cursor.next(file);
+    // The prefix is matched on the whole name, /x/ does not match /x
+    fs.insert(File("/x", DISKMIN));
+    FileCursor exact = fs.scanPrefix("/x/");
+    int count = 0;
+    while (exact.next(file)) count++;
+    fs.setOrderedIndex(false);
+    return empty and first and second and done and count == 2 and !fs.hasOrderedIndex();
+}
+
+bool Tester::testFindAllNorm() {
+    FileSys fs(MINPRIME, hashCode, QUADRATIC);
+    // Six names with eight blocks each, mixed with other names, like the driver's data
+    string names[6] = {"driver", "test", "readme", "notes", "main", "index"};
+    Random other(97, 122);
+    for (int block = 0; block < 8; block++) {
+        for (int n = 0; n < 6; n++) {
+            fs.insert(File(names[n], DISKMIN + block * 10 + n));
+        }
+        fs.insert(File(other.getRandString(8), DISKMIN + block));
+    }
+    // Remove two blocks of the first name
+    fs.remove(File(names[0], DISKMIN + 0));
+    fs.remove(File(names[0], DISKMIN + 70));
+
+    bool result = true;
+    for (int n = 0; n < 6; n++) {
+        vector<int> expected;
+        for (int block = 0; block < 8; block++) {
+            if (n == 0 and (block == 0 or block == 7)) continue;
+            expected.push_back(DISKMIN + block * 10 + n);
+        }
+        if (fs.findAll(names[n]) != expected) result = false;
+    }
+    // A missing name has no blocks
+    return result and fs.findAll("missing").empty();
+}
+
+bool Tester::testFrontCacheNorm() {
+    FileSys fs(MINPRIME, hashCode, QUADRATIC);
+    fs.setFrontCache(16);
+    for (int i = 0; i < 40; i++) {
+        fs.insert(File("file" + to_string(i), DISKMIN + i));
+    }
+    // The first lookup of a hot file misses the cache, the following ones hit
+    bool result = true;
+    for (int round = 0; round < 5; round++) {
+        for (int i = 0; i < 4; i++) {
+            if (!(fs.getFile("file" + to_string(i), DISKMIN + i) == File("file" + to_string(i), DISKMIN + i))) {
+                result = false;
+            }
+        }
+    }
+    // Misses of the table are misses of the cache too
+    bool missing = fs.getFile("file0", DISKMIN + 1).getName().empty();
+    FrontCache* cache = fs.m_cache;
+    return result and missing and cache->hits() == 16 and cache->misses() == 5 and cache->capacity() == 16;
+}
+
+bool Tester::testFrontCacheInvalidationEdge() {
+    FileSys fs(MINPRIME, hashCode, LINEAR);
+    fs.setFrontCache(8);
+    File file("hot", DISKMIN);
+    fs.insert(file);
+    fs.insert(File("hot", DISKMIN + 1));
+    fs.getFile("hot", DISKMIN); // cached now
+    fs.getFile("hot", DISKMIN + 1);
+    // A removed file is not served from the cache
+    fs.remove(file);
+    bool removed = !fs.getFile("hot", DISKMIN).getUsed();
+    // The deleted entry comes first on the chain; updated to the block of the cached
+    // live file it hides that file, like it does without the cache
+    fs.updateDiskBlock(File("hot", DISKMIN), DISKMIN + 1);
+    bool updated = !fs.getFile("hot", DISKMIN + 1).getUsed();
+    // A rehash moves the files, the cache is emptied and refilled from the new table
+    fs.insert(File("cold", DISKMIN + 2));
+    fs.getFile("cold", DISKMIN + 2);
+    for (int i = 0; i < MINPRIME / 2 + 1; i++) {
+        fs.insert(File("filler" + to_string(i), DISKMIN + i));
+    }
+    bool rehashed = fs.m_oldTable == nullptr and fs.m_currentCap > MINPRIME
+                    and fs.getFile("cold", DISKMIN + 2) == File("cold", DISKMIN + 2)
+                    and fs.getFile("cold", DISKMIN + 2).getUsed();
+    return removed and updated and rehashed;
+}
+
+bool Tester::testNegativeFilterNorm() {
+    FileSys fs(MINPRIME, hashCode, DOUBLEHASH);
+    fs.setNegativeFilter(true);
+    for (int i = 0; i < 40; i++) {
+        fs.insert(File("file" + to_string(i), DISKMIN + i));
+    }
+    // Every stored file is still found, and the misses mostly end at the filter
+    bool found = true;
+    for (int i = 0; i < 40; i++) {
+        if (!(fs.getFile("file" + to_string(i), DISKMIN + i) == File("file" + to_string(i), DISKMIN + i))) {
+            found = false;
+        }
+    }
+    fs.resetStats();
+    int misses = 0;
+    for (int i = 0; i < 200; i++) {
+        if (fs.getFile("missing" + to_string(i), DISKMIN + i).getName().empty()) misses++;
+    }
+    FileSysStats stats = fs.getStats();
+#ifdef FILESYS_STATS
+    bool filtered = stats.filterNegatives + stats.filterFalsePositives == 200 and stats.filterNegatives >= 190;
+#else
+    bool filtered = stats.filterNegatives == 0;
+#endif
+    return found and misses == 200 and filtered;
+}
+
+bool Tester::testNegativeFilterEdge() {
+    // The same random operations on a table with the filter and one without give the same answers,
+    // through deleted entries that are overwritten or updated and through several rehashes
+    FileSys plain(MINPRIME, hashCode, QUADRATIC);
+    FileSys filtered(MINPRIME, hashCode, QUADRATIC);
+    filtered.setNegativeFilter(true);
+    Random dice(0, 99);
+    Random names(0, 59);
+    Random blocks(DISKMIN, DISKMIN + 3);
+    bool same = true;
+    for (int i = 0; i < 3000; i++) {
+        int op = dice.getRandNum();
+        File file("name" + to_string(names.getRandNum()), blocks.getRandNum());
+        if (op < 40) {
+            same = same and plain.insert(file) == filtered.insert(file);
+        }else if (op < 60) {
+            same = same and plain.remove(file) == filtered.remove(file);
+        }else if (op < 70) {
+            int block = blocks.getRandNum();
+            same = same and plain.updateDiskBlock(file, block) == filtered.updateDiskBlock(file, block);
+        }else {
+            File a = plain.getFile(file.getName(), file.getDiskBlock());
+            File b = filtered.getFile(file.getName(), file.getDiskBlock());
+            same = same and a == b and a.getUsed() == b.getUsed();
+        }
+        if (i == 1500) {
+            // switching the filter off and on again rebuilds it from the table
+            filtered.setNegativeFilter(false);
+            filtered.setNegativeFilter(true);
+        }
+    }
+    return same and filtered.hasNegativeFilter() and !plain.hasNegativeFilter();
+}
+
+bool Tester::testCuckooNorm() {
+    FileSys fs(MINPRIME, hashCode, CUCKOO);
+    // Four blocks for each of 200 names, the table grows several times on the way
+    bool inserted = true;
+    for (int n = 0; n < 200; n++) {
+        for (int block = 0; block < CUCKOONAMEMAX; block++) {
+            if (!fs.insert(File("name" + to_string(n), DISKMIN + block))) inserted = false;
+        }
+    }
+    fs.resetStats();
+    bool found = true;
+    for (int n = 0; n < 200; n++) {
+        for (int block = 0; block < CUCKOONAMEMAX; block++) {
+            File file("name" + to_string(n), DISKMIN + block);
+            if (!(fs.getFile(file.getName(), file.getDiskBlock()) == file)) found = false;
+        }
+        if (!fs.getFile("name" + to_string(n), DISKMAX).getName().empty()) found = false;
+    }
+    // Every lookup looked at two buckets and the stash at most (3 probes, the <=4 bucket)
+    FileSysStats stats = fs.getStats();
+#ifdef FILESYS_STATS
+    bool bounded = stats.hits[STATFIND] == 800 and stats.misses[STATFIND] == 200;
+    for (int bucket = 3; bucket < PROBEBUCKETS; bucket++) {
+        if (stats.probeHistogram[STATFIND][bucket] != 0) bounded = false;
+    }
+#else
+    bool bounded = stats.hits[STATFIND] == 0;
+#endif
+    // findAll reads the two buckets of the name and the stash only
+    fs.resetStats();
+    vector<int> blocks = fs.findAll("name7");
+    bool all = blocks.size() == CUCKOONAMEMAX and blocks.front() == DISKMIN;
+#ifdef FILESYS_STATS
+    all = all and fs.getStats().hits[STATFIND] == 1 and fs.getStats().probeHistogram[STATFIND][2] == 1; // 3 probes
+#endif
+    return inserted and found and bounded and all and fs.lambda() <= 0.5 and fs.m_currProbing == CUCKOO;
+}
+
+bool Tester::testCuckooEdge() {
+    // Random inserts and removes checked against the set of live files; which deleted
+    // entries survive depends on the layout, so only the live files are compared
+    FileSys cuckoo(MINPRIME, hashCode, CUCKOO);
+    set<pair<string, int> > live;
+    vector<pair<string, int> > inserted;
+    Random dice(0, 99);
+    Random blocks(DISKMIN, DISKMIN + CUCKOONAMEMAX - 1);
+    bool same = true;
+    for (int i = 0; i < 3000; i++) {
+        int op = dice.getRandNum();
+        if (op < 50 or inserted.empty()) {
+            // a new (name, block) pair, names repeat with other blocks
+            pair<string, int> key("name" + to_string(i / 8), blocks.getRandNum());
+            if (find(inserted.begin(), inserted.end(), key) != inserted.end()) continue;
+            same = same and cuckoo.insert(File(key.first, key.second));
+            inserted.push_back(key);
+            live.insert(key);
+        }else if (op < 70) {
+            pair<string, int> key = inserted[dice.getRandNum() % inserted.size()];
+            // removing a deleted file again depends on whether its entry is still there
+            bool removed = cuckoo.remove(File(key.first, key.second));
+            same = same and (removed or live.count(key) == 0);
+            live.erase(key);
+        }else {
+            pair<string, int> key = inserted[dice.getRandNum() % inserted.size()];
+            same = same and cuckoo.getFile(key.first, key.second).getUsed() == (live.count(key) > 0);
+        }
+    }
+    for (unsigned int i = 0; i < inserted.size(); i += 8) {
+        vector<int> expected;
+        for (set<pair<string, int> >::iterator it = live.lower_bound(make_pair(inserted[i].first, 0));
+             it != live.end() and it->first == inserted[i].first; it++) {
+            expected.push_back(it->second);
+        }
+        same = same and cuckoo.findAll(inserted[i].first) == expected;
+    }
+    // Names that collide under hashCode, all with the same block, share both buckets:
+    // they overflow into the stash, which makes the table switch to the seeded hash
+    FileSys flooded(MINPRIME, hashCode, CUCKOO);
+    Random adversary(0, 1);
+    vector<string> colliding;
+    adversary.getCollidingNames(colliding, 3 * CUCKOOSLOTS);
+    bool stored = true;
+    for (unsigned int i = 0; i < colliding.size(); i++) {
+        if (!flooded.insert(File(colliding[i], DISKMIN))) stored = false;
+    }
+    for (unsigned int i = 0; i < colliding.size(); i++) {
+        if (!(flooded.getFile(colliding[i], DISKMIN) == File(colliding[i], DISKMIN))) stored = false;
+    }
+
+    // Once the flood has had its reseed, a file that finds neither a path nor room in
+    // the stash makes the table rebuild itself larger under a new seed
+    // (both buckets and the stash, which takes the slots left over by the buckets)
+    int room = 2 * CUCKOOSLOTS + MINPRIME - (MINPRIME - CUCKOOSTASH) / CUCKOOSLOTS * CUCKOOSLOTS;
+    vector<string> crowd;
+    adversary.getCollidingNames(crowd, room + 1);
+    int last = crowd.size() - 1;
+    FileSys full(MINPRIME, hashCode, CUCKOO);
+    full.m_reseeded = true;
+    for (int i = 0; i < last; i++) {
+        full.insert(File(crowd[i], DISKMIN));
+    }
+    bool crowded = full.m_currentCap == MINPRIME and !full.isSeededHash();
+    bool grown = full.insert(File(crowd[last], DISKMIN)) and full.m_currentCap > MINPRIME and full.isSeededHash();
+    for (unsigned int i = 0; i < crowd.size(); i++) {
+        if (!(full.getFile(crowd[i], DISKMIN) == File(crowd[i], DISKMIN))) grown = false;
+    }
+
+    // A deleted entry is not taken for a free slot: the files that fill its buckets make the
+    // table grow, the entry moves along, and updateDiskBlock changes it where it is
+    FileSys kept(MINPRIME, hashCode, CUCKOO);
+    kept.m_reseeded = true;
+    kept.insert(File("file0", DISKMIN + 1)); // keeps the deleted ratio under the purge
+    kept.insert(File(crowd[last], DISKMAX));
+    kept.remove(File(crowd[last], DISKMAX));
+    for (int i = 0; i < last; i++) {
+        kept.insert(File(crowd[i], DISKMIN));
+    }
+    bool updated = kept.m_currentCap > MINPRIME and kept.getFile(crowd[last], DISKMAX).getName() == crowd[last]
+                   and !kept.getFile(crowd[last], DISKMAX).getUsed() and kept.m_currNumDeleted == 1;
+    int capacity = kept.m_currentCap;
+    updated = updated and kept.updateDiskBlock(File(crowd[last], DISKMAX), DISKMIN) and kept.m_currentCap == capacity
+              and kept.getFile(crowd[last], DISKMIN).getName() == crowd[last] and !kept.getFile(crowd[last], DISKMIN).getUsed()
+              and kept.getFile(crowd[last], DISKMAX).getName().empty() and kept.getFile(crowd[0], DISKMIN).getUsed();
+
+    // A name gets CUCKOONAMEMAX live files, a removed one makes room for another
+    FileSys capped(MINPRIME, hashCode, CUCKOO);
+    capped.insert(File("other", DISKMIN)); // keeps the deleted ratio under the purge
+    bool limited = true;
+    for (int block = 0; block <= CUCKOONAMEMAX; block++) {
+        limited = limited and capped.insert(File("file", DISKMIN + block)) == (block < CUCKOONAMEMAX);
+    }
+    limited = limited and capped.remove(File("file", DISKMIN)) and capped.insert(File("file", DISKMIN + CUCKOONAMEMAX))
+              and capped.findAll("file").size() == CUCKOONAMEMAX and !capped.getFile("file", DISKMIN).getUsed();
+    // and a table with a name past that doesn't switch to CUCKOO
+    FileSys linear(MINPRIME, hashCode, LINEAR);
+    for (int block = 0; block <= CUCKOONAMEMAX; block++) {
+        linear.insert(File("file", DISKMIN + block));
+    }
+    linear.changeProbPolicy(CUCKOO);
+    limited = limited and linear.rehashNow() and linear.m_currProbing == LINEAR
+              and linear.findAll("file").size() == CUCKOONAMEMAX + 1;
+    return same and stored and flooded.isSeededHash() and crowded and grown and updated and limited;
+}
+
+bool Tester::testBlockAllocatorNorm() {
+    FileSys fs(MINPRIME, hashCode, LINEAR);
+    bool result = true;
+    // a table without the allocator can't pick blocks
+    result = result && (fs.freeBlock() == -1) && (fs.createFile("file0") == -1);
+
+    // the files already in the table hold their blocks
+    fs.insert(File("file0", DISKMIN + 1, true));
+    fs.setBlockAllocator(true);
+    result = result && fs.hasBlockAllocator();
+    result = result && (fs.createFile("file1") == DISKMIN);
+    result = result && (fs.createFile("file2") == DISKMIN + 2);
+    result = result && (fs.getFile("file2", DISKMIN + 2).getUsed());
+
+    // a removed file gives its block back
+    fs.remove(File("file1", DISKMIN));
+    result = result && (fs.freeBlock() == DISKMIN);
+    result = result && (fs.freeBlock(DISKMIN + 1) == DISKMIN + 3);
+    result = result && (fs.createFile("file3") == DISKMIN);
+
+    // the deleted entry of (file1, DISKMIN) blocks that pair, so file1 moves on to the next free block
+    fs.remove(File("file3", DISKMIN));
+    result = result && (fs.createFile("file1") == DISKMIN + 3);
+
+    // a run skips the blocks in use
+    fs.insert(File("file4", DISKMIN + 6, true));
+    result = result && (fs.freeRun(2) == DISKMIN + 4);
+    result = result && (fs.freeRun(3) == DISKMIN + 7);
+
+    // the blocks stay held through rehashes
+    for (int i = 0; i < 200; i++) {
+        result = result && (fs.createFile("many" + to_string(i)) != -1);
+    }
+    result = result && (fs.m_oldTable == nullptr) && (fs.m_currentCap > MINPRIME);
+    result = result && (fs.freeBlock() == DISKMIN + 204);
+    result = result && (fs.freeRun(3) == DISKMIN + 204);
+    return result;
+}
+
+bool Tester::testBlockAllocatorEdge() {
+    BlockAllocator blocks;
+    bool result = true;
+    result = result && (blocks.numFree() == NUMBLOCKS) && (blocks.findRun(NUMBLOCKS) == DISKMIN);
+    result = result && (blocks.findRun(NUMBLOCKS + 1) == -1) && (blocks.findRun(0) == -1);
+
+    // every block handed out once, in order
+    bool inOrder = true;
+    for (int block = DISKMIN; block <= DISKMAX; block++) {
+        inOrder = inOrder && (blocks.allocate() == block);
+    }
+    result = result && inOrder && (blocks.numFree() == 0);
+    result = result && (blocks.allocate() == -1) && (blocks.findFree() == -1) && (blocks.findRun(1) == -1);
+
+    // the last block alone, past every full summary word
+    blocks.release(DISKMAX);
+    result = result && (blocks.findFree() == DISKMAX) && (blocks.findRun(1) == DISKMAX);
+    result = result && (blocks.findRun(2) == -1) && (blocks.findFree(DISKMAX + 1) == -1);
+
+    // a run across word boundaries, and a shorter gap before it
+    int start = DISKMIN + 64 * 70 + 60;
+    for (int block = start; block < start + 70; block++) {
+        blocks.release(block);
+    }
+    blocks.release(DISKMIN + 5);
+    blocks.release(DISKMIN + 6);
+    result = result && (blocks.findFree() == DISKMIN + 5);
+    result = result && (blocks.findRun(2) == DISKMIN + 5);
+    result = result && (blocks.findRun(3) == start) && (blocks.findRun(70) == start);
+    result = result && (blocks.findRun(71) == -1);
+    result = result && (blocks.allocateRun(70) == start) && (blocks.numFree() == 3);
+
+    // a block held twice turns free after the second release only
+    blocks.acquire(DISKMAX);
+    blocks.acquire(DISKMAX);
+    blocks.release(DISKMAX);
+    result = result && !blocks.isFree(DISKMAX);
+    blocks.release(DISKMAX);
+    result = result && blocks.isFree(DISKMAX);
+    return result;
+}
+
+bool Tester::testFreezeNorm() {
+    FileSys fs(1000, hashCode, QUADRATIC);
+    Random RndID(DISKMIN, DISKMAX);
+    Random RndName(97, 122);
+    vector<File> files;
+    bool result = true;
+    for (int i = 0; i < 45; i++) {
+        File file(RndName.getRandString(8), RndID.getRandNum(), true);
+        if (fs.insert(file)) {
+            files.push_back(file);
+        }
+    }
+    // the first few files are deleted before the table is frozen
+    for (int i = 0; i < 5; i++) {
+        fs.remove(files[i]);
+    }
+    fs.insert(File("same", DISKMIN, true));
+    fs.insert(File("same", DISKMAX, true));
+    size_t before = fs.footprint();
+    fs.freeze();
+    result = result && fs.isFrozen() && (fs.footprint() < before);
+
+    // every live file is found, the deleted ones are gone
+    for (size_t i = 0; i < files.size(); i++) {
+        File found = fs.getFile(files[i].getName(), files[i].getDiskBlock());
+        if (i < 5) {
+            result = result && (found.getName() == "");
+        }else {
+            result = result && (found == files[i]) && found.getUsed();
+        }
+    }
+    result = result && (fs.getFile("same", DISKMAX + 1).getName() == "");
+    result = result && (fs.findAll("same") == vector<int>({DISKMIN, DISKMAX}));
+
+    // the table is read-only
+    result = result && !fs.insert(File("new", DISKMIN, true));
+    result = result && !fs.remove(files[5]) && !fs.updateDiskBlock(files[6], DISKMIN + 1);
+    result = result && fs.getFile(files[5].getName(), files[5].getDiskBlock()).getUsed();
+    return result;
+}
+
+bool Tester::testFreezeEdge() {
+    bool result = true;
+    // an empty table freezes into a table that finds nothing
+    FileSys empty(MINPRIME, hashCode, LINEAR);
+    empty.freeze();
+    result = result && empty.isFrozen() && (empty.getFile("file", DISKMIN).getName() == "");
+
+    // a large table with colliding names: one probe per lookup, hit or miss
+    FileSys fs(MINPRIME, hashCode, DOUBLEHASH);
+    Random RndID(DISKMIN, DISKMAX);
+    vector<string> names;
+    Random adversary(0, 1);
+    adversary.getCollidingNames(names, 50);
+    vector<File> files;
+    for (int i = 0; i < 20000; i++) {
+        string name = (i % 10 == 0) ? names[i / 10 % names.size()] : "/catalog/item" + to_string(i);
+        File file(name, RndID.getRandNum(), true);
+        if (fs.insert(file)) {
+            files.push_back(file);
+        }
+    }
+    fs.freeze();
+    fs.resetStats();
+    for (size_t i = 0; i < files.size(); i++) {
+        result = result && (fs.getFile(files[i].getName(), files[i].getDiskBlock()) == files[i]);
+        result = result && (fs.getFile("/missing/item" + to_string(i), files[i].getDiskBlock()).getName() == "");
+    }
+#ifdef FILESYS_STATS
+    FileSysStats stats = fs.getStats();
+    result = result && (stats.probeHistogram[STATFIND][0] == 2 * files.size());
+    result = result && (stats.hits[STATFIND] == files.size());
+#endif
+    // findAll searches the files sorted by name instead of reading all of them
+    vector<int> expected;
+    for (size_t i = 0; i < files.size(); i++) {
+        if (files[i].getName() == names[0]) {
+            expected.push_back(files[i].getDiskBlock());
+        }
+    }
+    sort(expected.begin(), expected.end());
+    fs.resetStats();
+    result = result && (expected.size() > 1) && (fs.findAll(names[0]) == expected) && fs.findAll("/missing").empty();
+#ifdef FILESYS_STATS
+    // a binary search over ~20000 files and the ~40 files of the name, no more than 128 reads
+    for (int bucket = 8; bucket < PROBEBUCKETS; bucket++) {
+        result = result && (fs.getStats().probeHistogram[STATFIND][bucket] == 0);
+    }
+#endif
+
+    // a table frozen in the middle of a transfer is left with no transfer going on
+    // (the maintenance thread waits too long between its runs to finish the transfer first)
+    FileSys moving(MINPRIME, hashCode, LINEAR);
+    moving.setBackgroundMaintenance(true, 200, 10000000);
+    for (int i = 0; i < MINPRIME / 2 + 1; i++) {
+        moving.insert(File("file" + to_string(i), DISKMIN + i));
+    }
+    bool transferring = moving.m_oldTable != nullptr;
+    moving.freeze();
+    result = result && transferring && (moving.m_transferIndex == -1)
+             && (moving.getFile("file0", DISKMIN) == File("file0", DISKMIN));
+    moving.setBackgroundMaintenance(false);
+
+    // a repeated pair is stored once instead of stalling the build of the perfect hash
+    vector<pair<string, int> > pairs;
+    pairs.push_back(make_pair("file", DISKMIN));
+    pairs.push_back(make_pair("file", DISKMIN));
+    pairs.push_back(make_pair("other", DISKMIN));
+    FrozenTable repeated(pairs);
+    result = result && (repeated.size() == 2) && (repeated.find("file", DISKMIN) != -1)
+             && (repeated.find("other", DISKMIN) != -1);
+    return result;
+}
+
+bool Tester::testShmFileSysNorm() {
+    string segment = "/filesys_test_" + to_string(getpid());
+    ShmFileSys* writer = ShmFileSys::create(segment, 1000, hashCode, QUADRATIC);
+    if (writer == nullptr) {
+        return false;
+    }
+    Random RndID(DISKMIN, DISKMAX);
+    Random RndName(97, 122);
+    vector<File> files;
+    bool result = writer->isWriter() && (writer->capacity() == 1009);
+    for (int i = 0; i < 200; i++) {
+        File file(RndName.getRandString(6 + i % 20), RndID.getRandNum(), true);
+        if (writer->insert(file)) {
+            files.push_back(file);
+        }
+    }
+    writer->remove(files[0]);
+
+    // another process maps the segment and finds the same files
+    pid_t child = fork();
+    if (child == 0) {
+        ShmFileSys* reader = ShmFileSys::open(segment, hashCode);
+        bool found = (reader != nullptr) && !reader->isWriter();
+        for (size_t i = 1; found && i < files.size(); i++) {
+            found = (reader->getFile(files[i].getName(), files[i].getDiskBlock()) == files[i]);
+        }
+        found = found && !reader->getFile(files[0].getName(), files[0].getDiskBlock()).getUsed();
+        found = found && (reader->getFile("missing", DISKMIN).getName() == "");
+        found = found && !reader->insert(File("new", DISKMIN, true)) && !reader->remove(files[1]);
+        delete reader;
+        _exit(found ? 0 : 1);
+    }
+    int status = 1;
+    waitpid(child, &status, 0);
+    result = result && WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+
+    // a reader in this process sees the writer's changes as they happen
+    ShmFileSys* reader = ShmFileSys::open(segment, hashCode);
+    result = result && (reader != nullptr);
+    if (reader != nullptr) {
+        result = result && reader->getFile(files[1].getName(), files[1].getDiskBlock()).getUsed();
+        writer->remove(files[1]);
+        result = result && !reader->getFile(files[1].getName(), files[1].getDiskBlock()).getUsed();
+        result = result && (reader->lambda() == writer->lambda());
+        delete reader;
+    }
+    delete writer;
+    // the writer removes the segment
+    result = result && (ShmFileSys::open(segment, hashCode) == nullptr);
+    return result;
+}
+
+bool Tester::testShmFileSysEdge() {
+    string segment = "/filesys_test_edge_" + to_string(getpid());
+    bool result = true;
+    result = result && (ShmFileSys::create(segment, MINPRIME, hashCode, CUCKOO) == nullptr);
+    result = result && (ShmFileSys::open(segment, hashCode) == nullptr);
+
+    // the table can't grow: it refuses files past a 0.5 load factor, and names past the name area
+    ShmFileSys* writer = ShmFileSys::create(segment, MINPRIME, hashCode, LINEAR, 60);
+    if (writer == nullptr) {
+        return false;
+    }
+    // a segment that exists already is left to its writer
+    result = result && (ShmFileSys::create(segment, MINPRIME, hashCode, LINEAR) == nullptr);
+    result = result && writer->insert(File("abcdefghij", DISKMIN, true));
+    for (int i = 1; i < 5; i++) {
+        result = result && writer->insert(File("abcdefghij", DISKMIN + i, true));
+    }
+    result = result && writer->insert(File("abcdefghij", DISKMIN + 5, true));
+    result = result && !writer->insert(File("abcdefghij", DISKMIN + 6, true));
+    delete writer;
+
+    writer = ShmFileSys::create(segment, MINPRIME, hashCode, DOUBLEHASH);
+    if (writer == nullptr) {
+        return false;
+    }
+    int inserted = 0;
+    for (int i = 0; i < MINPRIME; i++) {
+        inserted += writer->insert(File("file" + to_string(i), DISKMIN + i, true));
+    }
+    result = result && (inserted == MINPRIME / 2);
+    // a deleted entry's bucket can still be reused
+    writer->remove(File("file0", DISKMIN));
+    result = result && !writer->insert(File("other", DISKMIN, true));
+    result = result && writer->insert(File("file0", DISKMAX, true)) && (writer->deletedRatio() == 0);
+
+    // a reader process keeps finding the files that stay while the writer changes others
+    pid_t child = fork();
+    if (child == 0) {
+        ShmFileSys* reader = ShmFileSys::open(segment, hashCode);
+        bool found = (reader != nullptr);
+        for (int round = 0; found && round < 2000; round++) {
+            for (int i = 1; found && i < 20; i++) {
+                found = reader->getFile("file" + to_string(i), DISKMIN + i).getUsed();
+            }
+        }
+        delete reader;
+        _exit(found ? 0 : 1);
+    }
+    for (int round = 0; round < 2000; round++) {
+        for (int i = 20; i < MINPRIME / 2; i++) {
+            writer->remove(File("file" + to_string(i), DISKMIN + i));
+            writer->updateDiskBlock(File("file" + to_string(i), DISKMIN + i), DISKMAX - i);
+            writer->updateDiskBlock(File("file" + to_string(i), DISKMAX - i), DISKMIN + i);
+        }
+    }
+    int status = 1;
+    waitpid(child, &status, 0);
+    result = result && WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+    delete writer;
+    return result;
+}
+
+bool Tester::testShmNameChurnEdge() {
+    string segment = "/filesys_test_churn_" + to_string(getpid());
+    const int files = 25;
+    // 25 files that stay and 25 that are removed and inserted again under new names of
+    // 4 to 13 bytes; the name area only holds the longest names of all of them once
+    ShmFileSys* writer = ShmFileSys::create(segment, MINPRIME, prefixHash, LINEAR, files * 3 + files * 13);
+    if (writer == nullptr) {
+        return false;
+    }
+    bool result = true;
+    vector<File> churned;
+    for (int i = 0; i < files; i++) {
+        string number = (i < 10 ? "0" : "") + to_string(i);
+        result = result && writer->insert(File("s" + number, DISKMIN + i, true));
+        churned.push_back(File("c" + number + "-", DISKMIN + i, true));
+        result = result && writer->insert(churned[i]);
+    }
+
+    // a reader process keeps finding the files that stay while their names move
+    pid_t child = fork();
+    if (child == 0) {
+        ShmFileSys* reader = ShmFileSys::open(segment, prefixHash);
+        bool found = (reader != nullptr);
+        for (int round = 0; found && round < 2000; round++) {
+            for (int i = 0; found && i < files; i++) {
+                found = reader->getFile("s" + string(i < 10 ? "0" : "") + to_string(i), DISKMIN + i).getUsed();
+            }
+        }
+        delete reader;
+        _exit(found ? 0 : 1);
+    }
+    // a new name takes the bucket of the one removed before it, whose name bytes are
+    // reused when it fits there and compacted away when it doesn't
+    for (int round = 1; round <= 200; round++) {
+        for (int i = 0; i < files; i++) {
+            result = result && writer->remove(churned[i]);
+            churned[i] = File(churned[i].getName().substr(0, 4) + string((round + i) % 10, 'x'),
+                              DISKMIN + round * files + i, true);
+            result = result && writer->insert(churned[i]);
+        }
+    }
+    int status = 1;
+    waitpid(child, &status, 0);
+    result = result && WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+    for (int i = 0; i < files; i++) {
+        result = result && writer->getFile(churned[i].getName(), churned[i].getDiskBlock()).getUsed();
+    }
+    result = result && (writer->deletedRatio() == 0);
+    delete writer;
+    return result;
+}
+
+bool Tester::testBackgroundMaintenanceNorm() {
+    // the thread waits a long time before its first run, so the transfer stays pending here
+    FileSys fs(MINPRIME, hashCode, QUADRATIC);
+    fs.setBackgroundMaintenance(true, 200, 10000000);
+    bool result = fs.hasBackgroundMaintenance();
+    vector<File> files;
+    for (int i = 0; i < 51; i++) {
+        files.push_back(File("file" + to_string(i), DISKMIN + i, true));
+        result = result && fs.insert(files.back());
+    }
+    // the insert that passed the 0.5 load factor only swapped the tables
+    result = result && (fs.m_oldTable != nullptr) && (fs.m_transferIndex == 0) && (fs.m_currentSize == 0);
+    for (size_t i = 0; i < files.size(); i++) {
+        result = result && (fs.getFile(files[i].getName(), files[i].getDiskBlock()) == files[i]);
+    }
+    // a file still in the old table is a duplicate, and can be removed from there
+    result = result && !fs.insert(files[0]);
+    result = result && fs.remove(files[1]) && !fs.getFile(files[1].getName(), files[1].getDiskBlock()).getUsed();
+    result = result && (fs.findAll("file2") == vector<int>({DISKMIN + 2}));
+
+    // stopping the thread finishes the transfer
+    fs.setBackgroundMaintenance(false);
+    result = result && !fs.hasBackgroundMaintenance() && (fs.m_oldTable == nullptr) && (fs.m_transferIndex == -1);
+    result = result && (fs.m_currentSize - fs.m_currNumDeleted == 50);
+    for (size_t i = 0; i < files.size(); i++) {
+        result = result && (fs.getFile(files[i].getName(), files[i].getDiskBlock()).getUsed() == (i != 1));
+    }
+    return result;
+}
+
+bool Tester::testBackgroundMaintenanceEdge() {
+    FileSys fs(MINPRIME, hashCode, DOUBLEHASH);
+    fs.setBackgroundMaintenance(true, 100, 100);
+    bool result = true;
+
+    // two threads insert and one looks the files up while the table grows in the background
+    const int perThread = 3000;
+    bool found[2] = {true, true};
+    vector<thread> workers;
+    for (int t = 0; t < 2; t++) {
+        workers.push_back(thread([&fs, &found, t]() {
+            for (int i = 0; i < perThread; i++) {
+                File file("thread" + to_string(t) + "_" + to_string(i), DISKMIN + i, true);
+                found[t] = fs.insert(file) && found[t];
+                found[t] = (fs.getFile(file.getName(), file.getDiskBlock()) == file) && found[t];
+            }
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); t++) {
+        workers[t].join();
+    }
+    result = result && found[0] && found[1];
+
+    // half of the files deleted (below the 0.8 of remove), the thread drops the deleted entries
+    fs.setBackgroundMaintenance(false);
+    for (int i = 0; i < perThread; i++) {
+        fs.remove(File("thread0_" + to_string(i), DISKMIN + i));
+    }
+    result = result && (fs.deletedRatio() >= PURGERATIO);
+    fs.setBackgroundMaintenance(true, 100, 100);
+    for (int wait = 0; wait < 1000 and fs.deletedRatio() > 0; wait++) {
+        this_thread::sleep_for(chrono::milliseconds(2));
+    }
+    result = result && (fs.deletedRatio() == 0);
+    fs.setBackgroundMaintenance(false);
+    result = result && (fs.m_currentSize == perThread) && (fs.lambda() < GROWLOAD);
+    for (int i = 0; i < perThread; i++) {
+        result = result && fs.getFile("thread1_" + to_string(i), DISKMIN + i).getUsed();
+    }
+#ifdef FILESYS_STATS
+    result = result && (fs.getStats().maintenanceRuns > 0);
+#endif
+    return result;
+}
+
+bool Tester::testBackgroundSettersEdge() {
+    FileSys fs(MINPRIME, hashCode, QUADRATIC);
+    fs.setBackgroundMaintenance(true, 50, 50);
+    bool result = true;
+    // the settings change while the thread transfers and grows the table
+    for (int i = 0; i < 2000; i++) {
+        fs.insert(File("file" + to_string(i), DISKMIN + i, true));
+    }
+    fs.setSeededHash(true);
+    fs.changeProbPolicy(DOUBLEHASH);
+    fs.setNegativeFilter(true);
+    fs.setOrderedIndex(true);
+    fs.resetStats();
+    for (int i = 2000; i < 3000; i++) {
+        fs.insert(File("file" + to_string(i), DISKMIN + i, true));
+    }
+    int listed = 0;
+    FileCursor cursor = fs.scanPrefix("file");
+    File file;
+    while (cursor.next(file)) {
+        listed++;
+    }
+    result = result && (listed == 3000) && fs.isSeededHash();
+
+    // freeze frees the tables the thread works on
+    fs.freeze();
+    for (int i = 0; i < 3000; i++) {
+        result = result && fs.getFile("file" + to_string(i), DISKMIN + i).getUsed();
+    }
+    this_thread::sleep_for(chrono::milliseconds(5));
+    fs.setBackgroundMaintenance(false);
+    result = result && fs.isFrozen() && !fs.insert(File("late", DISKMIN));
+    return result;
+}
+
+bool Tester::testPurgeInPlaceNorm() {
+    bool result = true;
+    prob_t policies[] = {LINEAR, QUADRATIC, DOUBLEHASH, CUCKOO};
+    for (int p = 0; p < 4; p++) {
+        FileSys fs(1000, hashCode, policies[p]);
+        // 40 names with 10 blocks each make long chains, every third name is stored on the heap;
+        // a CUCKOO name holds at most CUCKOONAMEMAX files, so it takes 101 names with 4 blocks
+        int names = policies[p] == CUCKOO ? 101 : 40;
+        vector<File> files;
+        for (int i = 0; i < 401; i++) {
+            string name = (i % 3 == 0 ? "a_rather_long_file_name_" : "file") + to_string(i % names);
+            files.push_back(File(name, DISKMIN + i, true));
+            result = result && fs.insert(files[i]);
+        }
+        Slot* table = fs.m_currentTable;
+        int capacity = fs.m_currentCap;
+#ifdef FILESYS_STATS
+        FileSysStats before = fs.getStats(); // the long chains may have made insert reseed the table
+#endif
+
+        // the remove that passes a deleted ratio of 0.8 clears the deleted entries in the same table
+        int removeAmt = 0.8 * files.size() + 1;
+        for (int i = 0; i < removeAmt; i++) {
+            result = result && fs.remove(files[i]);
+        }
+        result = result && (fs.m_currentTable == table) && (fs.m_currentCap == capacity) && (fs.m_oldTable == nullptr);
+        result = result && (fs.m_currNumDeleted == 0) && (fs.m_currentSize == (int)files.size() - removeAmt);
+        for (size_t i = 0; i < files.size(); i++) {
+            File found = fs.getFile(files[i].getName(), files[i].getDiskBlock());
+            result = result && ((int)i < removeAmt ? found.getName() == "" : found == files[i]);
+        }
+#ifdef FILESYS_STATS
+        FileSysStats stats = fs.getStats();
+        result = result && (stats.purgeCount == 1) && (stats.rehashCount == before.rehashCount)
+                        && (stats.bytesAllocated == before.bytesAllocated);
+#endif
+        // the buckets are free again
+        for (int i = 0; i < removeAmt; i++) {
+            result = result && fs.insert(files[i]);
+        }
+        result = result && (fs.m_currentTable == table) && (fs.m_currentSize == (int)files.size());
+    }
+    return result;
+}
+
+bool Tester::testPurgeInPlaceEdge() {
+    bool result = true;
+    // a table far larger than its live files is rebuilt smaller instead of purged
+    FileSys big(10000, hashCode, LINEAR);
+    for (int i = 0; i < 101; i++) {
+        big.insert(File("file" + to_string(i), DISKMIN + i));
+    }
+    for (int i = 0; i < 81; i++) {
+        big.remove(File("file" + to_string(i), DISKMIN + i));
+    }
+    result = result && (big.m_currentCap == big.findNextPrime(4 * 20)) && (big.m_currentSize == 20);
+
+    // a policy change waiting for the next rehash is not skipped by a purge
+    FileSys fs(MINPRIME, hashCode, LINEAR);
+    for (int i = 0; i < 51; i++) {
+        fs.insert(File("file" + to_string(i), DISKMIN + i));
+    }
+    fs.changeProbPolicy(QUADRATIC);
+    for (int i = 0; i < 41; i++) {
+        fs.remove(File("file" + to_string(i), DISKMIN + i));
+    }
+    result = result && (fs.m_currProbing == QUADRATIC) && (fs.m_currentSize == 10);
+
+    // every file removed, the purge leaves an empty table
+    FileSys empty(MINPRIME, hashCode, DOUBLEHASH);
+    for (int i = 0; i < 4; i++) {
+        empty.insert(File("file", DISKMIN + i));
+    }
+    for (int i = 0; i < 4; i++) {
+        empty.remove(File("file", DISKMIN + i));
+    }
+    result = result && (empty.m_currentCap == MINPRIME) && (empty.m_currentSize == 0) && (empty.lambda() == 0);
+    for (int i = 0; i < MINPRIME; i++) {
+        result = result && !empty.m_currentTable[i].occupied();
+    }
+    return result;
+}
+
+bool Tester::testAdaptivePolicyNorm() {
+    // the names of ten files share a hash and the hashes of the next ten follow it,
+    // so a QUADRATIC table of them probes long chains and DOUBLEHASH spreads them best
+    FileSys fs(MINPRIME, groupHash, QUADRATIC);
+    fs.setAdaptivePolicy(true);
+    bool result = fs.isAdaptivePolicy();
+    for (int i = 0; i < 2000; i++) {
+        result = result && fs.insert(File("file" + to_string(i), DISKMIN + i));
+    }
+    // fewer operations than a window, nothing changes yet
+    result = result && (fs.m_currProbing == QUADRATIC);
+
+    // the lookups fill the window, the next insert checks it and moves the files
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 2000; i++) {
+            result = result && fs.getFile("file" + to_string(i), DISKMIN + i).getUsed();
+        }
+    }
+    result = result && fs.insert(File("file2000", DISKMIN + 2000));
+    result = result && (fs.m_currProbing == DOUBLEHASH) && (fs.m_oldTable == nullptr);
+    for (int i = 0; i <= 2000; i++) {
+        result = result && fs.getFile("file" + to_string(i), DISKMIN + i).getUsed();
+    }
+    // the new policy is the best one, so it stays
+    result = result && (fs.suggestPolicy() == DOUBLEHASH);
+#ifdef FILESYS_STATS
+    result = result && (fs.getStats().policyChanges == 1);
+#endif
+    return result;
+}
+
+bool Tester::testAdaptiveReadOnlyNorm() {
+    // the same QUADRATIC table of long chains as testAdaptivePolicyNorm
+    FileSys fs(MINPRIME, groupHash, QUADRATIC);
+    fs.setAdaptivePolicy(true);
+    bool result = true;
+    for (int i = 0; i < 2000; i++) {
+        result = result && fs.insert(File("file" + to_string(i), DISKMIN + i));
+    }
+    // the lookups fill the window and nothing else comes, the maintenance thread checks it
+    fs.setBackgroundMaintenance(true, 200, 1000);
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 2000; i++) {
+            result = result && fs.getFile("file" + to_string(i), DISKMIN + i).getUsed();
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    fs.setBackgroundMaintenance(false);
+    result = result && (fs.m_currProbing == DOUBLEHASH) && (fs.m_oldTable == nullptr);
+    for (int i = 0; i < 2000; i++) {
+        result = result && fs.getFile("file" + to_string(i), DISKMIN + i).getUsed();
+    }
+
+    // without the thread, the next updateDiskBlock checks a window filled by lookups
+    FileSys updated(MINPRIME, groupHash, QUADRATIC);
+    updated.setAdaptivePolicy(true);
+    for (int i = 0; i < 2000; i++) {
+        updated.insert(File("file" + to_string(i), DISKMIN + i));
+    }
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 2000; i++) {
+            updated.getFile("file" + to_string(i), DISKMIN + i);
+        }
+    }
+    result = result && (updated.m_currProbing == QUADRATIC);
+    updated.updateDiskBlock(File("missing", DISKMIN), DISKMIN + 1);
+    result = result && (updated.m_currProbing == DOUBLEHASH);
+    return result;
+}
+
+bool Tester::testAdaptivePolicyEdge() {
+    bool result = true;
+    // without the adaptive mode the long probes change nothing by themselves
+    FileSys fs(MINPRIME, groupHash, QUADRATIC);
+    for (int i = 0; i < 2000; i++) {
+        fs.insert(File("file" + to_string(i), DISKMIN + i));
+    }
+    for (int i = 0; i < 5000; i++) {
+        fs.getFile("file" + to_string(i % 2000), DISKMIN + i % 2000);
+    }
+    fs.insert(File("file2000", DISKMIN + 2000));
+    result = result && (fs.m_currProbing == QUADRATIC) && (fs.suggestPolicy() != QUADRATIC);
+
+    // but a migration can be asked for, it happens right away
+    prob_t best = fs.suggestPolicy();
+    result = result && fs.adaptPolicy() && (fs.m_currProbing == best) && (fs.m_oldTable == nullptr);
+    result = result && !fs.adaptPolicy();
+    for (int i = 0; i <= 2000; i++) {
+        result = result && fs.getFile("file" + to_string(i), DISKMIN + i).getUsed();
+    }
+
+    // an empty table and a CUCKOO table keep their policy
+    FileSys empty(MINPRIME, groupHash, LINEAR);
+    result = result && (empty.suggestPolicy() == LINEAR) && !empty.adaptPolicy();
+    FileSys cuckoo(MINPRIME, groupHash, CUCKOO);
+    for (int i = 0; i < 30; i++) {
+        cuckoo.insert(File("file" + to_string(i), DISKMIN + i));
+    }
+    result = result && (cuckoo.suggestPolicy() == CUCKOO) && !cuckoo.adaptPolicy();
+    return result;
+}
+
+bool Tester::testHugePageAllocatorNorm() {
+    bool result = true;
+    HugePageAllocator hugePages;
+    {
+        // a MAXPRIME table is 2.4 MB, it gets a mapping of its own on a huge page boundary
+        FileSys fs(MAXPRIME, hashCode, DOUBLEHASH, &hugePages);
+        result = result && ((uintptr_t)fs.m_currentTable % HUGEPAGE == 0);
+        result = result && (hugePages.bytesMapped() >= MAXPRIME * sizeof(Slot));
+        for (int i = 0; i < 20000; i++) {
+            // every tenth name is too long for the slot and comes from malloc
+            string name = (i % 10 == 0 ? "a_rather_long_file_name_" : "file") + to_string(i);
+            result = result && fs.insert(File(name, DISKMIN + i));
+        }
+        for (int i = 0; i < 20000; i++) {
+            string name = (i % 10 == 0 ? "a_rather_long_file_name_" : "file") + to_string(i);
+            result = result && fs.getFile(name, DISKMIN + i).getUsed();
+        }
+    }
+    // the mapping is gone with the table
+    result = result && (hugePages.bytesMapped() == 0);
+
+    // a manager backs the tables of its tenants with huge pages
+    FileSysManager manager(64 * 1024 * 1024, hashCode);
+    result = result && manager.setHugePages(true) && manager.hasHugePages();
+    FileSys* big = manager.createTable("big", MAXPRIME);
+    FileSys* small = manager.createTable("small");
+    result = result && (big != nullptr) && (small != nullptr);
+    result = result && ((uintptr_t)big->m_currentTable % HUGEPAGE == 0);
+    result = result && big->insert(File("file", DISKMIN)) && small->insert(File("file", DISKMIN));
+    result = result && big->getFile("file", DISKMIN).getUsed() && small->getFile("file", DISKMIN).getUsed();
+    result = result && manager.dropTable("big") && (manager.m_hugePages->bytesMapped() == 0);
+    return result;
+}
+
+bool Tester::testHugePageAllocatorEdge() {
+    bool result = true;
+    // below a huge page the blocks come from malloc
+    HugePageAllocator hugePages(false, 0);
+    void* small = hugePages.allocate(HUGEPAGE - 1);
+    result = result && (small != nullptr) && (hugePages.bytesMapped() == 0);
+    hugePages.deallocate(small, HUGEPAGE - 1);
+
+    // explicit huge pages fall back to transparent ones when the pool is empty,
+    // either way the mapping is a whole number of huge pages
+    HugePageAllocator pool(true);
+    char* block = (char*)pool.allocate(HUGEPAGE + 1);
+    result = result && ((uintptr_t)block % HUGEPAGE == 0) && (pool.bytesMapped() == 2 * HUGEPAGE);
+    block[0] = 1;
+    block[HUGEPAGE] = 2;
+    result = result && (block[0] + block[HUGEPAGE] == 3);
+    pool.deallocate(block, HUGEPAGE + 1);
+    result = result && (pool.bytesMapped() == 0) && (pool.fallbacks() >= 0);
+    result = result && (HugePageAllocator::currentNode() >= 0);
+
+    // a manager can't switch once it has tables, their blocks came from malloc
+    FileSysManager manager(64 * 1024 * 1024, hashCode);
+    manager.createTable("tenant", MAXPRIME);
+    result = result && !manager.setHugePages(true) && !manager.hasHugePages();
+    return result;
+}
+
+bool Tester::testSnapshotNorm() {
+    bool result = true;
+    FileSys fs(MINPRIME, hashCode, QUADRATIC);
+    for (int i = 0; i < 40; i++) {
+        // every fourth name is too long for the slot
+        fs.insert(File((i % 4 == 0 ? "a_rather_long_file_name_" : "file") + to_string(i), DISKMIN + i));
+    }
+    fs.remove(File("file1", DISKMIN + 1));
+    Snapshot* snapshot = fs.snapshot();
+    // nothing is copied until a write
+    result = result && (snapshot != nullptr) && (fs.numSnapshots() == 1) && (snapshot->bytes() == 0);
+    result = result && (snapshot->size() == 39);
+
+    // the writes go on: a remove, an insert and a deleted entry moved to another block
+    fs.remove(File("file2", DISKMIN + 2));
+    fs.insert(File("file100", DISKMIN + 100));
+    fs.updateDiskBlock(File("file1", DISKMIN + 1), DISKMIN + 500);
+    result = result && (snapshot->bytes() > 0);
+    result = result && snapshot->getFile("file2", DISKMIN + 2).getUsed();
+    result = result && (snapshot->getFile("file100", DISKMIN + 100).getName() == "");
+    result = result && (snapshot->getFile("file1", DISKMIN + 1).getName() == "file1")
+                    && !snapshot->getFile("file1", DISKMIN + 1).getUsed();
+    result = result && !fs.getFile("file2", DISKMIN + 2).getUsed() && fs.getFile("file100", DISKMIN + 100).getUsed();
+
+    // the writes that rehash the table leave the snapshot as it was
+    for (int i = 200; i < 300; i++) {
+        fs.insert(File("file" + to_string(i), DISKMIN + i));
+    }
+    result = result && (fs.numSnapshots() == 0);
+    set<pair<string, int> > seen;
+    File file;
+    while (snapshot->next(file)) {
+        seen.insert(make_pair(file.getName(), file.getDiskBlock()));
+    }
+    result = result && ((int)seen.size() == 39) && (seen.count(make_pair(string("file1"), DISKMIN + 1)) == 0);
+    for (int i = 0; i < 40; i++) {
+        string name = (i % 4 == 0 ? "a_rather_long_file_name_" : "file") + to_string(i);
+        result = result && (snapshot->getFile(name, DISKMIN + i).getUsed() == (i != 1));
+    }
+    delete snapshot;
+    return result;
+}
+
+bool Tester::testSnapshotEdge() {
+    bool result = true;
+    // a CUCKOO table moves files between buckets on insert, the snapshot keeps its buckets
+    FileSys* cuckoo = new FileSys(1009, hashCode, CUCKOO);
+    for (int i = 0; i < 300; i++) {
+        cuckoo->insert(File("file" + to_string(i), DISKMIN + i));
+    }
+    Snapshot* before = cuckoo->snapshot();
+    for (int i = 300; i < 450; i++) {
+        cuckoo->insert(File("file" + to_string(i), DISKMIN + i));
+    }
+    for (int i = 0; i < 450; i++) {
+        result = result && (before->getFile("file" + to_string(i), DISKMIN + i).getUsed() == (i < 300));
+    }
+    // released snapshots stop being copied into, the others survive the table
+    Snapshot* released = cuckoo->snapshot();
+    result = result && (cuckoo->numSnapshots() == 2);
+    delete released;
+    result = result && (cuckoo->numSnapshots() == 1);
+    delete cuckoo;
+    result = result && before->getFile("file0", DISKMIN).getUsed() && (before->size() == 300);
+    delete before;
+
+    // an empty table, and a frozen one that needs no snapshot
+    FileSys fs(MINPRIME, hashCode, LINEAR);
+    Snapshot* empty = fs.snapshot();
+    fs.insert(File("file", DISKMIN));
+    File file;
+    result = result && (empty->size() == 0) && !empty->next(file) && (empty->getFile("file", DISKMIN).getName() == "");
+    delete empty;
+    fs.freeze();
+    result = result && (fs.snapshot() == nullptr);
+    return result;
+}
+
+bool Tester::testServerNorm() {
+    bool result = true;
+    string path = "/tmp/filesys_mytest_" + to_string(getpid()) + ".sock";
+    FileSys fs(MINPRIME, hashCode, QUADRATIC);
+    FileSysServer server(&fs, path);
+    if (!server.listen()) {
+        return false;
+    }
+    thread serverThread(&FileSysServer::run, &server);
+
+    // the synchronous calls answer like the table does
+    FileSysClient client;
+    result = result && client.connect(path) && client.insert(File("file0", DISKMIN));
+    result = result && client.insert(File("file1", DISKMIN + 1)) && !client.insert(File("file1", DISKMIN + 1));
+    result = result && client.getFile("file1", DISKMIN + 1).getUsed() && (client.getFile("file2", DISKMIN).getName() == "");
+    result = result && client.remove(File("file1", DISKMIN + 1)) && !client.getFile("file1", DISKMIN + 1).getUsed();
+    result = result && client.updateDiskBlock(File("file1", DISKMIN + 1), DISKMIN + 5);
+
+    // a pipeline of 400 requests sent at once comes back in order
+    for (int i = 0; i < 200; i++) {
+        client.add(TRACEINSERT, "file" + to_string(100 + i), DISKMIN + i);
+    }
+    for (int i = 0; i < 200; i++) {
+        client.add(TRACEGETFILE, "file" + to_string(100 + i), DISKMIN + i);
+    }
+    result = result && client.flush();
+    for (int i = 0; i < 400; i++) {
+        FsResponse response;
+        result = result && client.receive(response) && (response.status == FSHIT)
+                        && (response.op == (i < 200 ? TRACEINSERT : TRACEGETFILE)) && (response.block == DISKMIN + i % 200);
+    }
+    client.close();
+    server.stop();
+    serverThread.join();
+
+    // the requests reached the table, in fewer batches than requests
+    FsServerStats stats = server.stats();
+    result = result && (stats.requests == 408) && (stats.batches < stats.requests) && (stats.connections == 1);
+    result = result && fs.getFile("file299", DISKMIN + 199).getUsed() && !fs.getFile("file1", DISKMIN + 5).getUsed();
+    return result;
+}
+
+bool Tester::testServerEdge() {
+    bool result = true;
+    string path = "/tmp/filesys_mytest_" + to_string(getpid()) + ".sock";
+    FileSys fs(MINPRIME, hashCode, LINEAR);
+    FileSysServer server(&fs, path);
+    if (!server.listen()) {
+        return false;
+    }
+    thread serverThread(&FileSysServer::run, &server);
+
+    // a request cut in two on the socket is answered once all of it is there
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path.c_str());
+    result = result && (connect(fd, (sockaddr*)&address, sizeof(address)) == 0);
+    FsRequestHeader header = {TRACEINSERT, 0, 4, DISKMIN + 7, 0};
+    string request = string((const char*)&header, sizeof(header)) + "file";
+    result = result && (write(fd, request.data(), 5) == 5);
+    this_thread::sleep_for(chrono::milliseconds(20));
+    result = result && (write(fd, request.data() + 5, request.size() - 5) == (ssize_t)request.size() - 5);
+    FsResponse response;
+    result = result && (read(fd, &response, sizeof(response)) == sizeof(response)) && (response.status == FSHIT);
+
+    // an unknown operation is an error, and the server hangs up
+    header.op = NUMTRACEOPS;
+    result = result && (write(fd, &header, sizeof(header)) == sizeof(header));
+    result = result && (read(fd, &response, sizeof(response)) == sizeof(response)) && (response.status == FSERROR);
+    result = result && (read(fd, &response, sizeof(response)) == 0);
+    close(fd);
+
+    // the other clients are served on; one that leaves with its answers unread does no harm
+    FileSysClient leaving;
+    result = result && leaving.connect(path);
+    for (int i = 0; i < 1000; i++) {
+        leaving.add(TRACEGETFILE, "file", DISKMIN + 7);
+    }
+    result = result && leaving.flush();
+    leaving.close();
+    FileSysClient client;
+    result = result && client.connect(path) && client.getFile("file", DISKMIN + 7).getUsed();
+    // a name longer than FSMAXNAME isn't queued, and the connection goes on
+    string longName(FSMAXNAME + 1, 'n');
+    result = result && !client.add(TRACEINSERT, longName, DISKMIN) && !client.insert(File(longName, DISKMIN))
+             && client.getFile("file", DISKMIN + 7).getUsed();
+    client.close();
+
+    // a burst of requests far over FSREADLIMIT is read over several rounds, all of it answered
+    FileSysClient burst;
+    result = result && burst.connect(path);
+    const int requests = 4 * FSREADLIMIT / (int)(sizeof(FsRequestHeader) + 4);
+    for (int i = 0; i < requests; i++) {
+        burst.add(TRACEGETFILE, "file", DISKMIN + 7);
+    }
+    int answered = 0;
+    thread receiver([&burst, &answered, requests]() {
+        FsResponse answer;
+        while (answered < requests and burst.receive(answer) and answer.status == FSHIT) {
+            answered++;
+        }
+    });
+    result = result && burst.flush();
+    receiver.join();
+    result = result && (answered == requests);
+    burst.close();
+
+    // a second server leaves the socket of a live one alone
+    FileSysServer second(&fs, path);
+    result = result && !second.listen();
+    server.stop();
+    serverThread.join();
+    result = result && (access(path.c_str(), F_OK) == 0);
+
+    // a socket file nobody accepts on is replaced, a file of another kind is not
+    string stalePath = path + ".stale";
+    int stale = socket(AF_UNIX, SOCK_STREAM, 0);
+    strcpy(address.sun_path, stalePath.c_str());
+    result = result && (bind(stale, (sockaddr*)&address, sizeof(address)) == 0);
+    close(stale);
+    FileSysServer replacing(&fs, stalePath);
+    result = result && replacing.listen();
+    string plainPath = path + ".txt";
+    ofstream plain(plainPath.c_str());
+    plain.close();
+    FileSysServer refused(&fs, plainPath);
+    result = result && !refused.listen() && (access(plainPath.c_str(), F_OK) == 0);
+    std::remove(plainPath.c_str());
+
+    // a path too long for a socket address can't be served
+    FileSysServer tooLong(&fs, "/tmp/" + string(200, 'a'));
+    result = result && !tooLong.listen();
+    return result;
+}
+
+bool Tester::testRemoveChurnEdge() {
+    bool result = true;
+    FileSys fs(MINPRIME, hashCode, QUADRATIC);
+    fs.insert(File("file0", DISKMIN));
+    // files moved off their deleted entries and inserted again fill the buckets with deleted
+    // entries, the table is rebuilt before they leave no empty bucket on a probe sequence
+    for (int round = 0; round < 50; round++) {
+        for (int i = 0; i < 20; i++) {
+            fs.insert(File("churn" + to_string(i), DISKMIN + i));
+            fs.remove(File("churn" + to_string(i), DISKMIN + i));
+            fs.updateDiskBlock(File("churn" + to_string(i), DISKMIN + i), DISKMAX - round);
+        }
+        result = result && (fs.m_currentSize <= fs.m_currentCap / 2);
+    }
+    result = result && (fs.m_currentSize - fs.m_currNumDeleted == 1) && (fs.getFile("churn19", DISKMIN + 19).getName() == "");
+    return result;
+}
+
+bool Tester::testRemoveTwiceEdge() {
+    bool result = true;
+    // removing a deleted entry again succeeds, it is counted once
+    FileSys fs(MINPRIME, hashCode, QUADRATIC);
+    for (int i = 0; i < 10; i++) {
+        fs.insert(File("file" + to_string(i), DISKMIN + i));
+    }
+    for (int i = 0; i < 5; i++) {
+        result = result && fs.remove(File("file1", DISKMIN + 1));
+    }
+    result = result && (fs.m_currNumDeleted == 1) && (fs.deletedRatio() == 0.1f);
+    // so the 0.8 deleted ratio is only passed by removing that many files
+    for (int i = 2; i < 8; i++) {
+        fs.remove(File("file" + to_string(i), DISKMIN + i));
+        fs.remove(File("file" + to_string(i), DISKMIN + i));
+    }
+    result = result && (fs.m_currNumDeleted == 7) && (fs.m_currentSize == 10);
+
+    // the same for a file that is still in the old table of a transfer
+    // (the maintenance thread waits too long between its runs to finish the transfer)
+    FileSys moving(MINPRIME, hashCode, LINEAR);
+    moving.setBackgroundMaintenance(true, 200, 10000000);
+    for (int i = 0; i < MINPRIME / 2 + 1; i++) {
+        moving.insert(File("file" + to_string(i), DISKMIN + i));
+    }
+    result = result && (moving.m_oldTable != nullptr);
+    int oldDeleted = moving.m_oldNumDeleted;
+    result = result && moving.remove(File("file0", DISKMIN)) && moving.remove(File("file0", DISKMIN));
+    result = result && (moving.m_oldTable != nullptr) && (moving.m_oldNumDeleted == oldDeleted + 1);
+    moving.setBackgroundMaintenance(false);
+    return result;
+}
+
+bool Tester::testOccupiedPurgeEdge() {
+    bool result = true;
+    // 30 live files keep the deleted ratio under 0.8 until the table would be full,
+    // the new names inserted and removed next to them leave their deleted entries behind
+    FileSys fs(MINPRIME, hashCode, QUADRATIC);
+    for (int i = 0; i < 30; i++) {
+        fs.insert(File("file" + to_string(i), DISKMIN + i));
+    }
+    Slot* table = fs.m_currentTable;
+    bool bounded = true;
+    for (int i = 0; i < 500; i++) {
+        result = result && fs.insert(File("temp" + to_string(i), DISKMIN + i));
+        result = result && fs.remove(File("temp" + to_string(i), DISKMIN + i));
+        bounded = bounded && ((float)fs.m_currentSize / fs.m_currentCap <= OCCUPIEDMAX + 1.0 / MINPRIME);
+    }
+    // the deleted entries are cleared in the same table, the live files stay
+    result = result && bounded && (fs.m_currentTable == table) && (fs.deletedRatio() < 0.8);
+    for (int i = 0; i < 30; i++) {
+        result = result && fs.getFile("file" + to_string(i), DISKMIN + i).getUsed();
+    }
+#ifdef FILESYS_STATS
+    result = result && (fs.getStats().purgeCount > 0) && (fs.getStats().rehashCount == 0);
+#endif
+
+    // a table waiting for a policy change can't be purged, it is rebuilt under the new policy
+    FileSys pending(MINPRIME, hashCode, QUADRATIC);
+    for (int i = 0; i < 30; i++) {
+        pending.insert(File("file" + to_string(i), DISKMIN + i));
+    }
+    pending.changeProbPolicy(LINEAR);
+    for (int i = 0; i < 100; i++) {
+        pending.insert(File("temp" + to_string(i), DISKMIN + i));
+        pending.remove(File("temp" + to_string(i), DISKMIN + i));
+    }
+    result = result && (pending.m_currProbing == LINEAR) && (pending.m_currentSize <= pending.m_currentCap / 2 + 1);
+    result = result && pending.getFile("file29", DISKMIN + 29).getUsed();
+    return result;
+}
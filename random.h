@@ -0,0 +1,210 @@
+// CMSC 341 - Fall 2024 - Project 4
+#ifndef RANDOM_H
+#define RANDOM_H
+#include <math.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <string>
+using namespace std;
+enum RANDOM {UNIFORMINT, UNIFORMREAL, NORMAL, SHUFFLE, ZIPF};
+class Random {
+public:
+    Random(){}
+    Random(int min, int max, RANDOM type=UNIFORMINT, int mean=50, int stdev=20) : m_min(min), m_max(max), m_type(type)
+    {
+        if (type == NORMAL){
+            //the case of NORMAL to generate integer numbers with normal distribution
+            m_generator = std::mt19937(m_device());
+            //the data set will have the mean of 50 (default) and standard deviation of 20 (default)
+            //the mean and standard deviation can change by passing new values to constructor 
+            m_normdist = std::normal_distribution<>(mean,stdev);
+        }
+        else if (type == UNIFORMINT) {
+            //the case of UNIFORMINT to generate integer numbers
+            // Using a fixed seed value generates always the same sequence
+            // of pseudorandom numbers, e.g. reproducing scientific experiments
+            // here it helps us with testing since the same sequence repeats
+            m_generator = std::mt19937(10);// 10 is the fixed seed value
+            m_unidist = std::uniform_int_distribution<>(min,max);
+        }
+        else if (type == UNIFORMREAL) { //the case of UNIFORMREAL to generate real numbers
+            m_generator = std::mt19937(10);// 10 is the fixed seed value
+            m_uniReal = std::uniform_real_distribution<double>((double)min,(double)max);
+        }
+        else if (type == ZIPF) {
+            //the case of ZIPF to generate integer numbers with Zipfian popularity
+            //min is the most frequent value, min+1 the second most frequent, and so on
+            //the exponent is 1.0 (default) and can change by calling setZipfExponent
+            m_generator = std::mt19937(10);// 10 is the fixed seed value
+            setZipfExponent(1.0);
+        }
+        else { //the case of SHUFFLE to generate every number only once
+            m_generator = std::mt19937(m_device());
+        }
+    }
+    void setZipfExponent(double exponent){
+        // the probability of the k-th most frequent value is proportional to 1/k^exponent,
+        // the larger the exponent the more skewed the data set
+        // here we build the cumulative distribution once, a draw is then a binary search
+        m_zipfCdf.clear();
+        double sum = 0.0;
+        for (int k = 1; k <= m_max - m_min + 1; k++){
+            sum += 1.0 / pow((double)k, exponent);
+            m_zipfCdf.push_back(sum);
+        }
+        for (unsigned int i = 0; i < m_zipfCdf.size(); i++){
+            m_zipfCdf[i] /= sum;
+        }
+        m_uniReal = std::uniform_real_distribution<double>(0.0, 1.0);
+    }
+    void setSeed(int seedNum){
+        // we have set a default value for seed in constructor
+        // we can change the seed by calling this function after constructor call
+        // this gives us more randomness
+        m_generator = std::mt19937(seedNum);
+    }
+    void init(int min, int max){
+        m_min = min;
+        m_max = max;
+        m_type = UNIFORMINT;
+        m_generator = std::mt19937(10);// 10 is the fixed seed value
+        m_unidist = std::uniform_int_distribution<>(min,max);
+    }
+    void getShuffle(vector<int> & array){
+        // this function provides a list of all values between min and max
+        // in a random order, this function guarantees the uniqueness
+        // of every value in the list
+        // the user program creates the vector param and passes here
+        // here we populate the vector using m_min and m_max
+        for (int i = m_min; i<=m_max; i++){
+            array.push_back(i);
+        }
+        shuffle(array.begin(),array.end(),m_generator);
+    }
+
+    void getShuffle(int array[]){
+        // this function provides a list of all values between min and max
+        // in a random order, this function guarantees the uniqueness
+        // of every value in the list
+        // the param array must be of the size (m_max-m_min+1)
+        // the user program creates the array and pass it here
+        vector<int> temp;
+        for (int i = m_min; i<=m_max; i++){
+            temp.push_back(i);
+        }
+        std::shuffle(temp.begin(), temp.end(), m_generator);
+        vector<int>::iterator it;
+        int i = 0;
+        for (it=temp.begin(); it != temp.end(); it++){
+            array[i] = *it;
+            i++;
+        }
+    }
+
+    int getRandNum(){
+        // this function returns integer numbers
+        // the object must have been initialized to generate integers
+        int result = 0;
+        if(m_type == NORMAL){
+            //returns a random number in a set with normal distribution
+            //we limit random numbers by the min and max values
+            result = m_min - 1;
+            while(result < m_min || result > m_max)
+                result = m_normdist(m_generator);
+        }
+        else if (m_type == UNIFORMINT){
+            //this will generate a random number between min and max values
+            result = m_unidist(m_generator);
+        }
+        else if (m_type == ZIPF){
+            //returns a random number between min and max values with Zipfian popularity
+            double draw = m_uniReal(m_generator);
+            int rank = lower_bound(m_zipfCdf.begin(), m_zipfCdf.end(), draw) - m_zipfCdf.begin();
+            result = m_min + min(rank, m_max - m_min);
+        }
+        return result;
+    }
+
+    double getRealRandNum(){
+        // this function returns real numbers
+        // the object must have been initialized to generate real numbers
+        double result = m_uniReal(m_generator);
+        // a trick to return numbers only with two deciaml points
+        // for example if result is 15.0378, function returns 15.03
+        // to round up we can use ceil function instead of floor
+        result = std::floor(result*100.0)/100.0;
+        return result;
+    }
+
+    string getRandString(int size){
+        // the parameter size specifies the length of string we ask for
+        // to use ASCII char the number range in constructor must be set to 97 - 122
+        // and the Random type must be UNIFORMINT (it is default in constructor)
+        string output = "";
+        for (int i=0;i<size;i++){
+            output = output + (char)getRandNum();
+        }
+        return output;
+    }
+    
+    string getPathName(int fileNum, int depth, int fanout){
+        // returns a path name in the form /a/b/c/file_N, where N is fileNum
+        // the directories are picked at random among fanout names per level
+        // so that many names share the same prefix, like in a real namespace
+        // the directory names are the letters a-z, then d26, d27, ... for larger fanouts
+        std::uniform_int_distribution<> dirdist(0, fanout - 1);
+        string output = "";
+        for (int level = 0; level < depth; level++){
+            int dir = dirdist(m_generator);
+            if (dir < 26)
+                output = output + "/" + (char)('a' + dir);
+            else
+                output = output + "/d" + to_string(dir);
+        }
+        return output + "/file_" + to_string(fileNum);
+    }
+
+    void getCollidingNames(vector<string> & names, int count){
+        // this function provides count distinct names that all have the same value
+        // under the textbook hash function (val = val * 33 + c), in a random order
+        // "Ez", "FY" and "G8" hash to the same value (69*33+122 = 70*33+89 = 71*33+56)
+        // and since the hash is linear, any sequence of these blocks with the same
+        // length collides as well, which gives 3^blocks colliding names
+        const string blocks[3] = {"Ez", "FY", "G8"};
+        int length = 1;
+        long total = 3;
+        while (total < count){
+            length++;
+            total *= 3;
+        }
+        vector<string> all;
+        for (long i = 0; i < total; i++){
+            string name = "";
+            long digits = i;
+            for (int b = 0; b < length; b++){
+                name = name + blocks[digits % 3];
+                digits /= 3;
+            }
+            all.push_back(name);
+        }
+        std::shuffle(all.begin(), all.end(), m_generator);
+        names.insert(names.end(), all.begin(), all.begin() + count);
+    }
+
+    int getMin(){return m_min;}
+    int getMax(){return m_max;}
+    private:
+    int m_min;
+    int m_max;
+    RANDOM m_type;
+    std::random_device m_device;
+    std::mt19937 m_generator;
+    std::normal_distribution<> m_normdist;//normal distribution
+    std::uniform_int_distribution<> m_unidist;//integer uniform distribution
+    std::uniform_real_distribution<double> m_uniReal;//real uniform distribution
+    vector<double> m_zipfCdf;//cumulative distribution of the Zipfian ranks
+
+};
+
+#endif
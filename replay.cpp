@@ -0,0 +1,246 @@
+// CMSC 341 - Fall 2024 - Project 4
+// Workload replay harness. A trace recorded with FileSys::setTrace() is replayed
+// at full speed against a FileSys configuration (capacity, probing policy and
+// hash function), and the throughput and the latency distribution of every
+// operation type are reported. Replaying the same trace under different
+// configurations gives an offline A/B comparison on a real access pattern.
+//     ./filesys_replay synth trace.bin 100000
+//     ./filesys_replay info trace.bin
+//     ./filesys_replay replay trace.bin --policy=LINEAR --hash=murmur3
+#include "filesys.h"
+#include "hashes.h"
+#include "latency.h"
+#include "random.h"
+#include "trace.h"
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <vector>
+using namespace std;
+
+// Settings taken from the command line.
+struct ReplayOptions {
+    int size;           // initial capacity of the table
+    prob_t policy;      // collision handling policy
+    string hashName;    // one of the built-in hash functions
+    int repeat;         // number of times the trace is replayed
+    int seed;           // seed of the synthetic trace generator
+    int names;          // distinct names in the synthetic trace
+    double zipf;        // Zipfian exponent of the name popularity, 0 for uniform
+};
+
+void usage(const char* program){
+    cerr << "usage: " << program << " replay <trace> [--size=N] [--policy=QUADRATIC|DOUBLEHASH|LINEAR|CUCKOO]"
+         << " [--hash=" << hashNames() << "] [--repeat=N]" << endl;
+    cerr << "       " << program << " info <trace>" << endl;
+    cerr << "       " << program << " synth <trace> <operations> [--names=N] [--zipf=S] [--seed=N]" << endl;
+}
+
+// Replays the trace against fresh FileSys objects and prints the results.
+int replay(const string & filename, const ReplayOptions & options){
+    hash_fn hash = hashByName(options.hashName);
+    if (hash == nullptr) {
+        cerr << "unknown hash function " << options.hashName << ", expected one of: " << hashNames() << endl;
+        return 1;
+    }
+    // the whole trace is decoded up front so reading it is not part of the timing
+    TraceReader reader;
+    vector<TraceRecord> records;
+    if (!reader.open(filename)) {
+        cerr << "cannot read trace " << filename << endl;
+        return 1;
+    }
+    // a damaged trace is not replayed, its prefix would pass for the whole workload
+    if (reader.readAll(records) < 0) {
+        cerr << "trace " << filename << " is truncated or damaged after " << records.size() << " operations" << endl;
+        return 1;
+    }
+
+    LatencyStats latency[NUMTRACEOPS];
+    LatencyStats overall;
+    long hits[NUMTRACEOPS] = {0};
+    long long wall = 0;
+    for (int round = 0; round < options.repeat; round++) {
+        FileSys filesys(options.size, hash, options.policy);
+        BenchClock::time_point begin = BenchClock::now();
+        for (size_t i = 0; i < records.size(); i++) {
+            const TraceRecord & record = records[i];
+            bool hit = false;
+            BenchClock::time_point start = BenchClock::now();
+            switch (record.op) {
+                case TRACEINSERT:
+                    hit = filesys.insert(File(record.name, record.block, true));
+                    break;
+                case TRACEREMOVE:
+                    hit = filesys.remove(File(record.name, record.block));
+                    break;
+                case TRACEGETFILE:
+                    hit = !filesys.getFile(record.name, record.block).getName().empty();
+                    break;
+                case TRACEUPDATE:
+                    hit = filesys.updateDiskBlock(File(record.name, record.block), record.newBlock);
+                    break;
+            }
+            latency[record.op].add(elapsedNanos(start, BenchClock::now()));
+            hits[record.op] += hit;
+        }
+        wall += elapsedNanos(begin, BenchClock::now());
+    }
+
+    cout << "trace: " << filename << " (" << records.size() << " operations x " << options.repeat << ")" << endl;
+    cout << "config: size=" << options.size << " policy=" << policyName(options.policy)
+         << " hash=" << options.hashName << endl;
+    cout << left << setw(18) << "operation" << right << setw(10) << "count" << setw(8) << "hit%"
+         << setw(10) << "mean" << setw(9) << "p50" << setw(9) << "p90" << setw(9) << "p99"
+         << setw(9) << "p99.9" << setw(10) << "max" << endl;
+    for (int op = 0; op < NUMTRACEOPS; op++) {
+        overall.add(latency[op]);
+        if (latency[op].count() == 0) continue;
+        cout << left << setw(18) << traceOpName((trace_op_t)op) << right << setw(10) << latency[op].count()
+             << setw(8) << fixed << setprecision(1) << 100.0 * hits[op] / latency[op].count()
+             << setw(10) << latency[op].mean()
+             << setw(9) << latency[op].percentile(0.50) << setw(9) << latency[op].percentile(0.90)
+             << setw(9) << latency[op].percentile(0.99) << setw(9) << latency[op].percentile(0.999)
+             << setw(10) << latency[op].percentile(1.0) << endl;
+    }
+    cout << left << setw(18) << "all" << right << setw(10) << overall.count() << setw(8) << ""
+         << setw(10) << fixed << setprecision(1) << overall.mean()
+         << setw(9) << overall.percentile(0.50) << setw(9) << overall.percentile(0.90)
+         << setw(9) << overall.percentile(0.99) << setw(9) << overall.percentile(0.999)
+         << setw(10) << overall.percentile(1.0) << endl;
+    cout << "throughput: " << setprecision(0) << LatencyStats::throughput(overall.count(), wall) << " ops/s" << endl;
+    return 0;
+}
+
+// Prints the operation mix of a trace.
+int info(const string & filename){
+    TraceReader reader;
+    if (!reader.open(filename)) {
+        cerr << "cannot read trace " << filename << endl;
+        return 1;
+    }
+    long counts[NUMTRACEOPS] = {0};
+    long total = 0;
+    TraceRecord record;
+    while (reader.next(record)) {
+        counts[record.op]++;
+        total++;
+    }
+    cout << "trace: " << filename << " (" << total << " operations)" << endl;
+    for (int op = 0; op < NUMTRACEOPS; op++) {
+        cout << left << setw(18) << traceOpName((trace_op_t)op) << right << setw(10) << counts[op] << endl;
+    }
+    if (reader.isDamaged()) {
+        cerr << "trace " << filename << " is truncated or damaged after " << total << " operations" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Writes a synthetic trace by recording a random workload run against a FileSys
+// object: 50% getFile, 30% insert, 10% remove and 10% updateDiskBlock over a
+// fixed pool of names. With --zipf the names are picked with Zipfian popularity
+// instead of uniformly. It is a stand-in for a recorded production trace.
+int synth(const string & filename, long operations, const ReplayOptions & options){
+    TraceWriter writer;
+    if (!writer.open(filename)) {
+        cerr << "cannot write trace " << filename << endl;
+        return 1;
+    }
+    Random chars(97, 122);
+    Random length(6, 14);
+    Random blocks(DISKMIN, DISKMAX);
+    Random mix(0, 99);
+    chars.setSeed(options.seed);
+    length.setSeed(options.seed + 1);
+    blocks.setSeed(options.seed + 2);
+    mix.setSeed(options.seed + 3);
+    vector<string> names;
+    for (int i = 0; i < options.names; i++) {
+        names.push_back(chars.getRandString(length.getRandNum()));
+    }
+    Random pickName(0, options.names - 1, options.zipf > 0 ? ZIPF : UNIFORMINT);
+    pickName.setSeed(options.seed + 4);
+    if (options.zipf > 0) pickName.setZipfExponent(options.zipf);
+
+    FileSys filesys(MINPRIME, djb33Hash, DEFPOLCY);
+    filesys.setTrace(&writer);
+    vector<File> files; // files inserted so far, the targets of the hits
+    for (long i = 0; i < operations; i++) {
+        int dice = mix.getRandNum();
+        if (dice < 30 or files.empty()) {
+            File file(names[pickName.getRandNum()], blocks.getRandNum(), true);
+            if (filesys.insert(file)) files.push_back(file);
+        }else {
+            // picks one of the inserted files; the getFile calls miss every other time
+            File & file = files[blocks.getRandNum() % files.size()];
+            if (dice < 80) {
+                filesys.getFile(file.getName(), (dice & 1) ? file.getDiskBlock() : blocks.getRandNum());
+            }else if (dice < 90) {
+                filesys.remove(file);
+            }else {
+                filesys.updateDiskBlock(file, blocks.getRandNum());
+            }
+        }
+    }
+    filesys.setTrace(nullptr);
+    cout << "wrote " << writer.count() << " operations to " << filename << endl;
+    return 0;
+}
+
+int main(int argc, char** argv){
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+    string command = argv[1];
+    string filename = argv[2];
+    ReplayOptions options;
+    options.size = MINPRIME;
+    options.policy = DEFPOLCY;
+    options.hashName = "djb33";
+    options.repeat = 1;
+    options.seed = 10;
+    options.names = 1000;
+    options.zipf = 0;
+    long operations = 0;
+    int first = 3;
+    if (command == "synth") {
+        if (argc < 4) {
+            usage(argv[0]);
+            return 1;
+        }
+        operations = atol(argv[3]);
+        first = 4;
+    }
+    for (int i = first; i < argc; i++) {
+        string arg = argv[i];
+        if (arg.rfind("--size=", 0) == 0) {
+            options.size = atoi(arg.c_str() + strlen("--size="));
+        }else if (arg.rfind("--policy=", 0) == 0) {
+            if (!parsePolicy(arg.substr(strlen("--policy=")), options.policy)) {
+                usage(argv[0]);
+                return 1;
+            }
+        }else if (arg.rfind("--hash=", 0) == 0) {
+            options.hashName = arg.substr(strlen("--hash="));
+        }else if (arg.rfind("--repeat=", 0) == 0) {
+            options.repeat = max(1, atoi(arg.c_str() + strlen("--repeat=")));
+        }else if (arg.rfind("--seed=", 0) == 0) {
+            options.seed = atoi(arg.c_str() + strlen("--seed="));
+        }else if (arg.rfind("--zipf=", 0) == 0) {
+            options.zipf = atof(arg.c_str() + strlen("--zipf="));
+        }else if (arg.rfind("--names=", 0) == 0) {
+            options.names = max(1, atoi(arg.c_str() + strlen("--names=")));
+        }else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (command == "replay") return replay(filename, options);
+    if (command == "info") return info(filename);
+    if (command == "synth") return synth(filename, operations, options);
+    usage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,275 @@
+// CMSC 341 - Fall 2024 - Project 4
+// Metadata server and load generator. "serve" puts a FileSys table behind a Unix
+// domain socket (see fsserver.h for the protocol); "load" runs client threads
+// against it, each keeping a pipeline of requests in flight, and reports the
+// throughput and the round trip latency of a pipeline. With --local the load
+// command starts its own server in a thread, for a quick run without a second
+// process.
+//     ./filesys_server serve /tmp/filesys.sock --policy=LINEAR --hash=murmur3
+//     ./filesys_server load /tmp/filesys.sock --clients=4 --depth=32 --ops=1000000
+//     ./filesys_server load /tmp/filesys.sock --local --depth=1
+#include "filesys.h"
+#include "fsserver.h"
+#include "hashes.h"
+#include "latency.h"
+#include "random.h"
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Settings taken from the command line.
+struct ServerOptions {
+    int size;           // initial capacity of the table
+    prob_t policy;      // collision handling policy
+    string hashName;    // one of the built-in hash functions
+    int clients;        // client threads of the load generator
+    int depth;          // requests each client keeps in flight
+    long ops;           // requests sent by every client
+    int names;          // distinct names in the workload
+    int seed;           // seed of the first client, the next ones count up from it
+    bool local;         // the load command serves the socket itself
+};
+
+// Counters of one client thread.
+struct ClientResult {
+    LatencyStats roundTrips;    // nanoseconds from the flush to the last response of a pipeline
+    long requests;
+    long hits;
+    bool failed;
+};
+
+void usage(const char* program){
+    cerr << "usage: " << program << " serve <socket> [--size=N] [--policy=QUADRATIC|DOUBLEHASH|LINEAR|CUCKOO]"
+         << " [--hash=" << hashNames() << "]" << endl;
+    cerr << "       " << program << " load <socket> [--clients=N] [--depth=N] [--ops=N] [--names=N] [--seed=N]"
+         << " [--local [--size=N] [--policy=...] [--hash=...]]" << endl;
+}
+
+FileSysServer* activeServer = nullptr;
+
+void stopServer(int){
+    if (activeServer != nullptr) activeServer->stop();
+}
+
+// Serves the socket until SIGINT or SIGTERM.
+int serve(const string & path, const ServerOptions & options){
+    hash_fn hash = hashByName(options.hashName);
+    if (hash == nullptr) {
+        cerr << "unknown hash function " << options.hashName << ", expected one of: " << hashNames() << endl;
+        return 1;
+    }
+    FileSys filesys(options.size, hash, options.policy);
+    FileSysServer server(&filesys, path);
+    if (!server.listen()) {
+        cerr << "cannot listen on " << path << endl;
+        return 1;
+    }
+    activeServer = &server;
+    signal(SIGINT, stopServer);
+    signal(SIGTERM, stopServer);
+    cout << "serving " << path << " (size=" << options.size << " policy=" << policyName(options.policy)
+         << " hash=" << options.hashName << ")" << endl;
+    server.run();
+    activeServer = nullptr;
+    FsServerStats stats = server.stats();
+    cout << "served " << stats.requests << " requests in " << stats.batches << " batches over "
+         << stats.connections << " connections" << endl;
+    return 0;
+}
+
+// One client of the load: 50% getFile, 30% insert, 10% remove and 10%
+// updateDiskBlock over a pool of names, like the synthetic traces of
+// filesys_replay. A pipeline of depth requests is sent with one flush and its
+// responses are read before the next one goes out.
+void runClient(const string & path, const ServerOptions & options, int seed, ClientResult & result){
+    result.requests = 0;
+    result.hits = 0;
+    result.failed = false;
+    FileSysClient client;
+    if (!client.connect(path)) {
+        result.failed = true;
+        return;
+    }
+    Random chars(97, 122);
+    Random length(6, 14);
+    Random blocks(DISKMIN, DISKMAX);
+    Random mix(0, 99);
+    chars.setSeed(seed);
+    length.setSeed(seed + 1);
+    blocks.setSeed(seed + 2);
+    mix.setSeed(seed + 3);
+    vector<string> names;
+    for (int i = 0; i < options.names; i++) {
+        names.push_back(chars.getRandString(length.getRandNum()));
+    }
+    // every name keeps one block, so the table holds at most names files per client
+    // (the capacity of a FileSys table stops at MAXPRIME)
+    vector<int> nameBlocks;
+    for (int i = 0; i < options.names; i++) {
+        nameBlocks.push_back(blocks.getRandNum());
+    }
+    result.roundTrips.reserve(options.ops / options.depth + 1);
+
+    while (result.requests < options.ops) {
+        int count = (int)min((long)options.depth, options.ops - result.requests);
+        for (int i = 0; i < count; i++) {
+            int dice = mix.getRandNum();
+            int index = blocks.getRandNum() % options.names;
+            if (dice < 30) {
+                client.add(TRACEINSERT, names[index], nameBlocks[index]);
+            }else if (dice < 80) {
+                client.add(TRACEGETFILE, names[index], nameBlocks[index]);
+            }else if (dice < 90) {
+                client.add(TRACEREMOVE, names[index], nameBlocks[index]);
+            }else {
+                client.add(TRACEUPDATE, names[index], nameBlocks[index], blocks.getRandNum());
+            }
+        }
+        BenchClock::time_point start = BenchClock::now();
+        if (!client.flush()) {
+            result.failed = true;
+            return;
+        }
+        for (int i = 0; i < count; i++) {
+            FsResponse response;
+            if (!client.receive(response) or response.status == FSERROR) {
+                result.failed = true;
+                return;
+            }
+            result.hits += response.status == FSHIT;
+        }
+        result.roundTrips.add(elapsedNanos(start, BenchClock::now()));
+        result.requests += count;
+    }
+}
+
+// Runs the client threads and prints the results.
+int load(const string & path, const ServerOptions & options){
+    FileSys* filesys = nullptr;
+    FileSysServer* server = nullptr;
+    thread serverThread;
+    if (options.local) {
+        hash_fn hash = hashByName(options.hashName);
+        if (hash == nullptr) {
+            cerr << "unknown hash function " << options.hashName << ", expected one of: " << hashNames() << endl;
+            return 1;
+        }
+        filesys = new FileSys(options.size, hash, options.policy);
+        server = new FileSysServer(filesys, path);
+        if (!server->listen()) {
+            cerr << "cannot listen on " << path << endl;
+            delete server;
+            delete filesys;
+            return 1;
+        }
+        serverThread = thread(&FileSysServer::run, server);
+    }
+
+    vector<ClientResult> results(options.clients);
+    vector<thread> threads;
+    BenchClock::time_point begin = BenchClock::now();
+    for (int i = 0; i < options.clients; i++) {
+        threads.push_back(thread(runClient, cref(path), cref(options), options.seed + 10 * i, ref(results[i])));
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    long long wall = elapsedNanos(begin, BenchClock::now());
+
+    FsServerStats stats = {0, 0, 0, 0, 0};
+    if (server != nullptr) {
+        server->stop();
+        serverThread.join();
+        stats = server->stats();
+        delete server;
+        delete filesys;
+    }
+
+    LatencyStats roundTrips;
+    long requests = 0;
+    long hits = 0;
+    bool failed = false;
+    for (int i = 0; i < options.clients; i++) {
+        roundTrips.add(results[i].roundTrips);
+        requests += results[i].requests;
+        hits += results[i].hits;
+        failed = failed or results[i].failed;
+    }
+    if (failed) {
+        cerr << "a client lost its connection to " << path << endl;
+        return 1;
+    }
+    cout << "load: " << options.clients << " clients x " << options.ops << " requests, depth " << options.depth << endl;
+    cout << left << setw(18) << "round trip" << right << setw(10) << "count" << setw(8) << "hit%"
+         << setw(10) << "mean" << setw(9) << "p50" << setw(9) << "p90" << setw(9) << "p99"
+         << setw(9) << "p99.9" << setw(10) << "max" << endl;
+    cout << left << setw(18) << "pipeline" << right << setw(10) << roundTrips.count()
+         << setw(8) << fixed << setprecision(1) << (requests > 0 ? 100.0 * hits / requests : 0.0)
+         << setw(10) << roundTrips.mean()
+         << setw(9) << roundTrips.percentile(0.50) << setw(9) << roundTrips.percentile(0.90)
+         << setw(9) << roundTrips.percentile(0.99) << setw(9) << roundTrips.percentile(0.999)
+         << setw(10) << roundTrips.percentile(1.0) << endl;
+    if (options.local) {
+        cout << "server: " << stats.requests << " requests in " << stats.batches << " batches ("
+             << setprecision(1) << (stats.batches > 0 ? (double)stats.requests / stats.batches : 0.0)
+             << " per batch), " << stats.reads << " reads, " << stats.writes << " writes" << endl;
+    }
+    cout << "throughput: " << setprecision(0) << LatencyStats::throughput(requests, wall) << " ops/s" << endl;
+    return 0;
+}
+
+int main(int argc, char** argv){
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+    string command = argv[1];
+    string path = argv[2];
+    ServerOptions options;
+    options.size = MINPRIME;
+    options.policy = DEFPOLCY;
+    options.hashName = "djb33";
+    options.clients = 1;
+    options.depth = 16;
+    options.ops = 100000;
+    options.names = 1000;
+    options.seed = 10;
+    options.local = false;
+    for (int i = 3; i < argc; i++) {
+        string arg = argv[i];
+        if (arg.rfind("--size=", 0) == 0) {
+            options.size = atoi(arg.c_str() + strlen("--size="));
+        }else if (arg.rfind("--policy=", 0) == 0) {
+            if (!parsePolicy(arg.substr(strlen("--policy=")), options.policy)) {
+                usage(argv[0]);
+                return 1;
+            }
+        }else if (arg.rfind("--hash=", 0) == 0) {
+            options.hashName = arg.substr(strlen("--hash="));
+        }else if (arg.rfind("--clients=", 0) == 0) {
+            options.clients = max(1, atoi(arg.c_str() + strlen("--clients=")));
+        }else if (arg.rfind("--depth=", 0) == 0) {
+            options.depth = max(1, atoi(arg.c_str() + strlen("--depth=")));
+        }else if (arg.rfind("--ops=", 0) == 0) {
+            options.ops = max(1L, atol(arg.c_str() + strlen("--ops=")));
+        }else if (arg.rfind("--names=", 0) == 0) {
+            options.names = max(1, atoi(arg.c_str() + strlen("--names=")));
+        }else if (arg.rfind("--seed=", 0) == 0) {
+            options.seed = atoi(arg.c_str() + strlen("--seed="));
+        }else if (arg == "--local") {
+            options.local = true;
+        }else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (command == "serve") return serve(path, options);
+    if (command == "load") return load(path, options);
+    usage(argv[0]);
+    return 1;
+}
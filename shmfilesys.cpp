@@ -0,0 +1,336 @@
+// CMSC 341 - Fall 2024 - Project 4
+#include "shmfilesys.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// The slots start on a cache line of their own.
+static size_t slotsOffset() {
+    return (sizeof(ShmHeader) + 63) / 64 * 64;
+}
+
+static bool isPrimeSize(int number) {
+    if (number < 2) return false;
+    for (int i = 2; (long)i * i <= number; i++) {
+        if (number % i == 0) return false;
+    }
+    return true;
+}
+
+ShmFileSys* ShmFileSys::create(string segment, int size, hash_fn hash, prob_t probing, size_t nameBytes) {
+    if (probing == CUCKOO) {
+        return nullptr; // the cuckoo moves would need a stash and a path search in the segment
+    }
+    // the capacity follows the FileSys constructor
+    if (size < MINPRIME) size = MINPRIME;
+    if (size > MAXPRIME) size = MAXPRIME;
+    while (!isPrimeSize(size)) size++;
+    if (nameBytes == 0) {
+        nameBytes = (size_t)size * SHMNAMEBYTES;
+    }
+    size_t bytes = slotsOffset() + size * sizeof(ShmSlot) + nameBytes;
+
+    // an existing segment may still be in use, it is only removed by its writer
+    int fd = shm_open(segment.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd == -1) {
+        return nullptr;
+    }
+    if (ftruncate(fd, bytes) == -1) {
+        close(fd);
+        shm_unlink(segment.c_str());
+        return nullptr;
+    }
+    void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the segment open
+    if (base == MAP_FAILED) {
+        shm_unlink(segment.c_str());
+        return nullptr;
+    }
+    // a new segment is all zeros, which is an empty table
+    ShmHeader* header = new (base) ShmHeader();
+    header->sequence.store(0);
+    header->capacity = size;
+    header->size = 0;
+    header->numDeleted = 0;
+    header->probing = probing;
+    header->nameBytes = 0;
+    header->nameCapacity = nameBytes;
+    header->magic = SHMMAGIC;
+    return new ShmFileSys(segment, base, bytes, hash, true);
+}
+
+ShmFileSys* ShmFileSys::open(string segment, hash_fn hash) {
+    int fd = shm_open(segment.c_str(), O_RDONLY, 0);
+    if (fd == -1) {
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == -1 or (size_t)info.st_size < slotsOffset()) {
+        close(fd);
+        return nullptr;
+    }
+    size_t bytes = info.st_size;
+    void* base = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return nullptr;
+    }
+    const ShmHeader* header = (const ShmHeader*)base;
+    if (header->magic != SHMMAGIC
+        or slotsOffset() + header->capacity * sizeof(ShmSlot) + header->nameCapacity != bytes) {
+        munmap(base, bytes);
+        return nullptr;
+    }
+    return new ShmFileSys(segment, base, bytes, hash, false);
+}
+
+ShmFileSys::ShmFileSys(string segment, void* base, size_t bytes, hash_fn hash, bool writer):
+m_segment(segment),
+m_base((char*)base),
+m_bytes(bytes),
+m_hash(hash),
+m_writer(writer)
+{
+    m_header = (ShmHeader*)m_base;
+    m_slots = (ShmSlot*)(m_base + slotsOffset());
+    m_names = m_base + slotsOffset() + m_header->capacity * sizeof(ShmSlot);
+}
+
+ShmFileSys::~ShmFileSys() {
+    munmap(m_base, m_bytes);
+    if (m_writer) {
+        shm_unlink(m_segment.c_str());
+    }
+}
+
+/*
+The bucket is found the same way as in a FileSys table, except that the probe
+sequence stops after capacity buckets, since a reader may see a table the writer
+is in the middle of changing. firstFree is set to the first deleted or empty
+bucket on the way, where insert puts a new file.
+*/
+int ShmFileSys::probe(const string & name, int block, unsigned int hash, int & firstFree) const {
+    int capacity = m_header->capacity;
+    int origIndex = hash % capacity;
+    firstFree = -1;
+    for (int collisionAmt = 0; collisionAmt < capacity; collisionAmt++) {
+        int index = nextIndex(origIndex, hash, collisionAmt);
+        const ShmSlot & slot = m_slots[index];
+        unsigned long long word = __atomic_load_n(&slot.word, __ATOMIC_RELAXED);
+        if (!(word & SLOTOCCUPIED)) {
+            if (firstFree == -1) {
+                firstFree = index;
+            }
+            return -1;
+        }
+        if ((int)(word & SLOTBLOCKMASK) == block - DISKMIN and (unsigned int)(word >> SLOTHASHSHIFT) == hash
+            and nameEquals(slot, name)) {
+            return index;
+        }
+        if (!(word & SLOTUSED) and firstFree == -1) {
+            firstFree = index;
+        }
+    }
+    return -1;
+}
+
+int ShmFileSys::nextIndex(int origIndex, unsigned int hash, int collisionAmt) const {
+    int capacity = m_header->capacity;
+    switch (m_header->probing) {
+        case LINEAR:
+            return (origIndex + collisionAmt) % capacity;
+        case DOUBLEHASH:
+            return (origIndex + (long long)collisionAmt * (hash % (capacity - 1) + 1)) % capacity;
+        default:
+            return (origIndex + (long long)collisionAmt * collisionAmt) % capacity;
+    }
+}
+
+// The offsets are checked against the name area, a torn slot can hold any value.
+bool ShmFileSys::nameEquals(const ShmSlot & slot, const string & name) const {
+    unsigned int offset = __atomic_load_n(&slot.nameOffset, __ATOMIC_RELAXED);
+    unsigned int length = __atomic_load_n(&slot.nameLength, __ATOMIC_RELAXED);
+    return length == name.size() and (unsigned long long)offset + length <= m_header->nameCapacity
+           and memcmp(m_names + offset, name.data(), length) == 0;
+}
+
+void ShmFileSys::beginWrite() {
+    m_header->sequence.store(m_header->sequence.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+void ShmFileSys::endWrite() {
+    m_header->sequence.store(m_header->sequence.load(memory_order_relaxed) + 1, memory_order_release);
+}
+
+bool ShmFileSys::insert(File file) {
+    if (!m_writer or file.getDiskBlock() < DISKMIN or file.getDiskBlock() > DISKMAX) {
+        return false;
+    }
+    string name = file.getName();
+    unsigned int hash = m_hash(name);
+    int freeIndex;
+    if (probe(name, file.getDiskBlock(), hash, freeIndex) != -1 or freeIndex == -1) {
+        return false; // a duplicate, or no free bucket on the probe sequence
+    }
+    bool reused = (m_slots[freeIndex].word & SLOTOCCUPIED) != 0;
+    // the table can't grow, so a new bucket is only taken up to the 0.5 load factor
+    if (!reused and (float)(m_header->size + 1) / m_header->capacity > 0.5) {
+        return false;
+    }
+    // a reused bucket's name bytes take the new name if it fits there, otherwise it goes
+    // at the end of the name area, after a compaction if the area is used up
+    ShmSlot & slot = m_slots[freeIndex];
+    bool inPlace = reused and name.size() <= slot.nameLength;
+    int replaced = reused ? freeIndex : -1;
+    bool compact = !inPlace and m_header->nameBytes + name.size() > m_header->nameCapacity;
+    if (compact and namesInUse(replaced) + name.size() > m_header->nameCapacity) {
+        return false;
+    }
+
+    // the names are written under the sequence too, a reader may be comparing the ones replaced
+    beginWrite();
+    if (compact) {
+        compactNames(replaced);
+    }
+    unsigned int offset = inPlace ? slot.nameOffset : m_header->nameBytes;
+    memcpy(m_names + offset, name.data(), name.size());
+    __atomic_store_n(&slot.word, (unsigned long long)(file.getDiskBlock() - DISKMIN) | SLOTOCCUPIED | SLOTUSED
+                                 | ((unsigned long long)hash << SLOTHASHSHIFT), __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.nameOffset, offset, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.nameLength, (unsigned int)name.size(), __ATOMIC_RELAXED);
+    if (!inPlace) {
+        m_header->nameBytes += name.size();
+    }
+    if (reused) {
+        m_header->numDeleted--;
+    }else {
+        m_header->size++;
+    }
+    endWrite();
+    return true;
+}
+
+// Bytes of the names of the occupied buckets, without the one of skip.
+unsigned long long ShmFileSys::namesInUse(int skip) const {
+    unsigned long long bytes = 0;
+    for (int i = 0; i < m_header->capacity; i++) {
+        if ((m_slots[i].word & SLOTOCCUPIED) and i != skip) {
+            bytes += m_slots[i].nameLength;
+        }
+    }
+    return bytes;
+}
+
+/*
+Moves the names of the occupied buckets to the front of the name area, in the order
+of their offsets so that no name is overwritten before it moved. This frees the bytes
+of the names that were replaced by shorter ones. The name of skip, a bucket about to
+get a new one, is dropped. Called by the writer between beginWrite and endWrite, the
+readers that compared a name while it moved try again.
+*/
+void ShmFileSys::compactNames(int skip) {
+    vector<int> order;
+    for (int i = 0; i < m_header->capacity; i++) {
+        if ((m_slots[i].word & SLOTOCCUPIED) and i != skip) {
+            order.push_back(i);
+        }
+    }
+    sort(order.begin(), order.end(), [this](int first, int second) {
+        return m_slots[first].nameOffset < m_slots[second].nameOffset;
+    });
+    unsigned int offset = 0;
+    for (size_t i = 0; i < order.size(); i++) {
+        ShmSlot & slot = m_slots[order[i]];
+        memmove(m_names + offset, m_names + slot.nameOffset, slot.nameLength);
+        __atomic_store_n(&slot.nameOffset, offset, __ATOMIC_RELAXED);
+        offset += slot.nameLength;
+    }
+    if (skip != -1) {
+        __atomic_store_n(&m_slots[skip].nameLength, 0u, __ATOMIC_RELAXED);
+    }
+    m_header->nameBytes = offset;
+}
+
+bool ShmFileSys::remove(File file) {
+    if (!m_writer) {
+        return false;
+    }
+    int freeIndex;
+    int index = probe(file.getName(), file.getDiskBlock(), m_hash(file.getName()), freeIndex);
+    if (index == -1 or !(m_slots[index].word & SLOTUSED)) {
+        return false;
+    }
+    beginWrite();
+    __atomic_store_n(&m_slots[index].word, m_slots[index].word & ~SLOTUSED, __ATOMIC_RELAXED);
+    m_header->numDeleted++;
+    endWrite();
+    return true;
+}
+
+// Like FileSys::updateDiskBlock, only deleted entries are changed.
+bool ShmFileSys::updateDiskBlock(File file, int block) {
+    if (!m_writer or block < DISKMIN or block > DISKMAX) {
+        return false;
+    }
+    int freeIndex;
+    int index = probe(file.getName(), file.getDiskBlock(), m_hash(file.getName()), freeIndex);
+    if (index == -1 or (m_slots[index].word & SLOTUSED)) {
+        return false;
+    }
+    beginWrite();
+    __atomic_store_n(&m_slots[index].word, (m_slots[index].word & ~SLOTBLOCKMASK) | (unsigned long long)(block - DISKMIN),
+                     __ATOMIC_RELAXED);
+    endWrite();
+    return true;
+}
+
+/*
+A seqlock read: the lookup is repeated until it ran between two writes, which is
+when the sequence was even before it and the same after it.
+*/
+const File ShmFileSys::getFile(string name, int block) const {
+    if (block < DISKMIN or block > DISKMAX) {
+        return File();
+    }
+    unsigned int hash = m_hash(name);
+    while (true) {
+        unsigned long long before = m_header->sequence.load(memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        int freeIndex;
+        int index = probe(name, block, hash, freeIndex);
+        bool used = index != -1 and (__atomic_load_n(&m_slots[index].word, __ATOMIC_RELAXED) & SLOTUSED);
+        atomic_thread_fence(memory_order_acquire);
+        if (m_header->sequence.load(memory_order_relaxed) == before) {
+            return index == -1 ? File() : File(name, block, used);
+        }
+    }
+}
+
+float ShmFileSys::lambda() const {
+    return (float)(m_header->size - m_header->numDeleted) / m_header->capacity;
+}
+
+float ShmFileSys::deletedRatio() const {
+    return m_header->size > 0 ? (float)m_header->numDeleted / m_header->size : 0.0;
+}
+
+void ShmFileSys::dump() const {
+    cout << "Dump for the shared table: " << endl;
+    for (int i = 0; i < m_header->capacity; i++) {
+        const ShmSlot & slot = m_slots[i];
+        cout << "[" << i << "] : ";
+        if (slot.word & SLOTOCCUPIED) {
+            cout << string(m_names + slot.nameOffset, slot.nameLength) << " ("
+                 << DISKMIN + (int)(slot.word & SLOTBLOCKMASK) << ", " << ((slot.word & SLOTUSED) != 0) << ")";
+        }
+        cout << endl;
+    }
+}
@@ -0,0 +1,93 @@
+// CMSC 341 - Fall 2024 - Project 4
+#ifndef SHMFILESYS_H
+#define SHMFILESYS_H
+#include "filesys.h"
+#include <atomic>
+#include <cstddef>
+#include <string>
+using namespace std;
+
+const unsigned long long SHMMAGIC = 0x314d485353595346ULL; // "FSYSSHM1"
+const int SHMNAMEBYTES = 32; // name storage per bucket when the creator asks for none
+
+// The start of a shared FileSys segment. The slots follow the header and the
+// names follow the slots; everything refers to the names by their offset, so
+// every process can map the segment at a different address.
+struct ShmHeader{
+    unsigned long long magic;
+    atomic<unsigned long long> sequence; // odd while the writer is changing the table
+    int capacity;
+    int size;               // occupied buckets, deleted entries included
+    int numDeleted;
+    int probing;            // prob_t of the table
+    unsigned long long nameBytes;    // bytes of the name area in use
+    unsigned long long nameCapacity; // bytes of the name area
+};
+
+// One bucket: the word has the layout of Slot::m_word (block, flags and hash),
+// the name is nameLength bytes at nameOffset of the name area.
+struct ShmSlot{
+    unsigned long long word;
+    unsigned int nameOffset;
+    unsigned int nameLength;
+};
+
+// A FileSys table in a POSIX shared memory segment, built by one writer process
+// and read by any number of other processes.
+//
+// The table has a fixed capacity, since the segment can't be moved under its
+// readers: insert refuses files past a 0.5 load factor instead of rehashing.
+// The writer brackets every change with a sequence counter (a seqlock); a reader
+// never takes a lock, it reads the table and tries again if the counter was odd
+// or has moved in the meantime. A name is appended to the name area, or written
+// over the name of the deleted entry whose bucket it reuses if it fits there; when
+// the area is used up, the writer moves the names together to free the bytes of the
+// replaced ones. Names are only changed inside a write, so a reader that compared
+// one while it changed tries again. Deleted entries follow FileSys: they stay
+// found by getFile with m_used false, and block the same (name, block) pair
+// until the table is built again.
+class ShmFileSys{
+    public:
+    // creates the segment and opens it for writing, fails if one of the same name exists;
+    // size is rounded up to a prime like FileSys, nameBytes = 0 sizes the name area by the
+    // capacity. Returns nullptr if the segment can't be created or the policy is CUCKOO.
+    static ShmFileSys* create(string segment, int size, hash_fn hash, prob_t probing = DEFPOLCY, size_t nameBytes = 0);
+    // opens an existing segment read-only, with the writer's hash function;
+    // returns nullptr if it doesn't exist or isn't a FileSys segment
+    static ShmFileSys* open(string segment, hash_fn hash);
+    // unmaps the segment, the writer also removes its name (readers keep their mapping)
+    ~ShmFileSys();
+    bool isWriter() const {return m_writer;}
+    // the changes are refused for readers
+    bool insert(File file);
+    bool remove(File file);
+    bool updateDiskBlock(File file, int block);
+    const File getFile(string name, int block) const;
+    float lambda() const;
+    float deletedRatio() const;
+    int capacity() const {return m_header->capacity;}
+    // bytes of the segment, shared by every process that maps it
+    size_t bytes() const {return m_bytes;}
+    void dump() const;
+    private:
+    ShmFileSys(string segment, void* base, size_t bytes, hash_fn hash, bool writer);
+
+    string     m_segment;   // shm_open name
+    char*      m_base;      // the mapping
+    size_t     m_bytes;
+    hash_fn    m_hash;
+    bool       m_writer;
+    ShmHeader* m_header;
+    ShmSlot*   m_slots;
+    char*      m_names;
+
+    int probe(const string & name, int block, unsigned int hash, int & firstFree) const; // bucket of the pair, -1 if missing
+    int nextIndex(int origIndex, unsigned int hash, int collisionAmt) const;
+    bool nameEquals(const ShmSlot & slot, const string & name) const;
+    unsigned long long namesInUse(int skip) const; // bytes of the names of the occupied buckets but skip
+    void compactNames(int skip);                     // moves the names to the front of the name area
+    void beginWrite();
+    void endWrite();
+};
+
+#endif
@@ -0,0 +1,166 @@
+// CMSC 341 - Fall 2024 - Project 4
+#include "trace.h"
+#include <cstring>
+
+// zigzag encoding keeps small negative numbers small as varints
+static unsigned int zigzag(int value){
+    return ((unsigned int)value << 1) ^ (unsigned int)(value >> 31);
+}
+
+static int unzigzag(unsigned int value){
+    return (int)(value >> 1) ^ -(int)(value & 1);
+}
+
+TraceWriter::TraceWriter() : m_count(0){}
+
+TraceWriter::~TraceWriter(){
+    close();
+}
+
+bool TraceWriter::open(string filename){
+    close();
+    m_names.clear();
+    m_count = 0;
+    m_out.open(filename.c_str(), ios::binary | ios::trunc);
+    if (!m_out) {
+        return false;
+    }
+    m_out.write(TRACEMAGIC, strlen(TRACEMAGIC));
+    return (bool)m_out;
+}
+
+void TraceWriter::close(){
+    if (m_out.is_open()) {
+        m_out.close();
+    }
+}
+
+void TraceWriter::record(trace_op_t op, const string & name, int block, int newBlock){
+    if (!m_out.is_open() or name.size() > TRACEMAXNAME) {
+        return;
+    }
+    m_out.put((char)op);
+    unordered_map<string, unsigned int>::iterator it = m_names.find(name);
+    if (it != m_names.end()) {
+        writeVarint(it->second);
+    }else {
+        // a reference one past the known names introduces a new name
+        unsigned int index = m_names.size();
+        m_names[name] = index;
+        writeVarint(index);
+        writeVarint(name.size());
+        m_out.write(name.data(), name.size());
+    }
+    writeVarint(zigzag(block));
+    if (op == TRACEUPDATE) {
+        writeVarint(zigzag(newBlock));
+    }
+    m_count++;
+}
+
+void TraceWriter::writeVarint(unsigned int value){
+    while (value >= 0x80) {
+        m_out.put((char)((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    m_out.put((char)value);
+}
+
+TraceReader::TraceReader() : m_damaged(false){}
+
+bool TraceReader::open(string filename){
+    m_names.clear();
+    m_damaged = false;
+    m_in.open(filename.c_str(), ios::binary);
+    if (!m_in) {
+        return false;
+    }
+    char magic[sizeof(TRACEMAGIC)] = {0};
+    m_in.read(magic, strlen(TRACEMAGIC));
+    return m_in and strcmp(magic, TRACEMAGIC) == 0;
+}
+
+bool TraceReader::next(TraceRecord & record){
+    if (!m_in.is_open() or m_damaged) {
+        return false;
+    }
+    // the end of the file is only the end of the trace between two records
+    int op = m_in.get();
+    if (op == EOF) {
+        return false;
+    }
+    m_damaged = true;
+    if (op < 0 or op >= NUMTRACEOPS) {
+        return false;
+    }
+    record.op = (trace_op_t)op;
+
+    unsigned int index = 0;
+    if (!readVarint(index) or index > m_names.size()) {
+        return false;
+    }
+    if (index == m_names.size()) {
+        // a bad length would otherwise allocate up to 4 GiB before the read fails
+        unsigned int length = 0;
+        if (!readVarint(length) or length > TRACEMAXNAME) {
+            return false;
+        }
+        string name(length, '\0');
+        m_in.read(&name[0], length);
+        if (!m_in) {
+            return false;
+        }
+        m_names.push_back(name);
+    }
+    record.name = m_names[index];
+
+    unsigned int value = 0;
+    if (!readVarint(value)) {
+        return false;
+    }
+    record.block = unzigzag(value);
+    record.newBlock = 0;
+    if (record.op == TRACEUPDATE) {
+        if (!readVarint(value)) {
+            return false;
+        }
+        record.newBlock = unzigzag(value);
+    }
+    m_damaged = false;
+    return true;
+}
+
+long TraceReader::readAll(vector<TraceRecord> & records){
+    long count = 0;
+    TraceRecord record;
+    while (next(record)) {
+        records.push_back(record);
+        count++;
+    }
+    return m_damaged ? -1 : count;
+}
+
+bool TraceReader::readVarint(unsigned int & value){
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        int byte = m_in.get();
+        if (byte == EOF) {
+            return false;
+        }
+        value |= (unsigned int)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* traceOpName(trace_op_t op){
+    switch (op) {
+        case TRACEINSERT: return "insert";
+        case TRACEREMOVE: return "remove";
+        case TRACEGETFILE: return "getFile";
+        case TRACEUPDATE: return "updateDiskBlock";
+    }
+    return "unknown";
+}
@@ -0,0 +1,75 @@
+// CMSC 341 - Fall 2024 - Project 4
+#ifndef TRACE_H
+#define TRACE_H
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// Operation trace of a FileSys object in a compact binary format.
+//
+// File layout: the 8 byte magic "FSTRACE1" followed by one record per operation.
+// Every record starts with the operation byte and the name reference, a varint
+// index into the table of names seen so far in the trace. An index equal to the
+// number of names seen so far introduces a new name, stored right after it as a
+// varint length and the raw bytes. The disk block follows as a zigzag varint,
+// and updateDiskBlock records add the new block the same way. A repeated name
+// with a block in [DISKMIN-DISKMAX] costs 4 to 6 bytes.
+enum trace_op_t {TRACEINSERT, TRACEREMOVE, TRACEGETFILE, TRACEUPDATE};
+const int NUMTRACEOPS = 4;
+const char TRACEMAGIC[] = "FSTRACE1";
+const unsigned int TRACEMAXNAME = 64 * 1024; // longest name a trace may hold, a longer length is a damaged record
+
+struct TraceRecord{
+    trace_op_t op;
+    string name;
+    int block;
+    int newBlock;   // only used by TRACEUPDATE
+};
+
+// Appends operations to a trace file. A FileSys object records its operations
+// once it is given a writer with FileSys::setTrace().
+class TraceWriter{
+    public:
+    TraceWriter();
+    ~TraceWriter();
+    // creates (or truncates) the trace file, returns false if it cannot be written
+    bool open(string filename);
+    void close();
+    bool isOpen() const {return m_out.is_open();}
+    // an operation on a name longer than TRACEMAXNAME is left out, the reader could not take it back
+    void record(trace_op_t op, const string & name, int block, int newBlock = 0);
+    long count() const {return m_count;}     // records written so far
+    private:
+    ofstream m_out;
+    unordered_map<string, unsigned int> m_names; // name -> index in the trace's name table
+    long m_count;
+
+    void writeVarint(unsigned int value);
+};
+
+// Reads the records of a trace file back in order.
+class TraceReader{
+    public:
+    TraceReader();
+    // opens the trace file, returns false if it is missing or not a trace
+    bool open(string filename);
+    // reads the next record, returns false at the end of the trace or on a damaged record
+    bool next(TraceRecord & record);
+    // reads every remaining record into the vector, returns the number read or -1 if
+    // the trace is truncated or damaged (the records before the damage are kept)
+    long readAll(vector<TraceRecord> & records);
+    // true once next() stopped on a truncated or damaged record instead of the end of the trace
+    bool isDamaged() const {return m_damaged;}
+    private:
+    ifstream m_in;
+    vector<string> m_names;  // index -> name
+    bool m_damaged;
+
+    bool readVarint(unsigned int & value);
+};
+
+const char* traceOpName(trace_op_t op);
+
+#endif